@@ -0,0 +1,459 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Cache-blocked, register-tiled replacements for the reference
+ * Fortran DGEMM and DSYRK in blas.f.
+ *
+ * The structure follows the usual Goto/BLIS scheme: op(B) is packed
+ * into KC x NC panels of NR columns, op(A) into MC x KC panels of MR
+ * rows, and an MR x NR microkernel accumulates the product in
+ * registers.  An AVX2/FMA microkernel is selected at run time where
+ * the CPU supports it; otherwise a portable C kernel (which the
+ * compiler is free to vectorise) is used.  The MC blocks of each panel
+ * are shared out between OpenMP threads when Rblas is built with
+ * OpenMP and the product is large enough to make that worthwhile.
+ *
+ * Unlike the reference implementation, these routines never skip a
+ * term because an element of A or B is zero, so NA and NaN values
+ * propagate into the result as they do in R's own arithmetic
+ * (PR#4582).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <R_ext/BLAS.h>
+
+/* Provided by R itself (see print.cpp). */
+extern void F77_NAME(xerbla)(const char *srname, int *info);
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+/* Register tile.  8 x 4 fills eight of the sixteen ymm registers with
+ * accumulators, leaving room for two columns of A and a broadcast
+ * element of B. */
+#define MR 8
+#define NR 4
+
+/* Cache blocks: an MC x KC panel of A should sit in L2, a KC x NR
+ * sliver of B in L1, and a KC x NC panel of B in L3. */
+#define MC 128
+#define KC 256
+#define NC 2048
+
+/* Products with fewer multiply-adds than this are not worth packing. */
+#define SMALL_GEMM 32768.0
+
+/* Products with fewer multiply-adds than this run on one thread. */
+#define PARALLEL_GEMM 4.0e6
+
+typedef void (*microkernel_t)(int kc, const double *a, const double *b,
+			      double *ab);
+
+/* ab[MR x NR] = a[MR x kc] * b[kc x NR], both operands packed. */
+static void microkernel_generic(int kc, const double *a, const double *b,
+				double *ab)
+{
+    double acc[MR * NR];
+    memset(acc, 0, sizeof(acc));
+    for (int p = 0; p < kc; p++) {
+	for (int j = 0; j < NR; j++) {
+	    double bpj = b[j];
+	    for (int i = 0; i < MR; i++)
+		acc[i + j * MR] += a[i] * bpj;
+	}
+	a += MR;
+	b += NR;
+    }
+    memcpy(ab, acc, sizeof(acc));
+}
+
+#ifdef HAVE_AVX2_KERNEL
+__attribute__((target("avx2,fma")))
+static void microkernel_avx2(int kc, const double *a, const double *b,
+			     double *ab)
+{
+    __m256d c00 = _mm256_setzero_pd(), c10 = _mm256_setzero_pd();
+    __m256d c01 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c02 = _mm256_setzero_pd(), c12 = _mm256_setzero_pd();
+    __m256d c03 = _mm256_setzero_pd(), c13 = _mm256_setzero_pd();
+    for (int p = 0; p < kc; p++) {
+	__m256d a0 = _mm256_loadu_pd(a);
+	__m256d a1 = _mm256_loadu_pd(a + 4);
+	__m256d bj;
+	bj = _mm256_broadcast_sd(b);
+	c00 = _mm256_fmadd_pd(a0, bj, c00);
+	c10 = _mm256_fmadd_pd(a1, bj, c10);
+	bj = _mm256_broadcast_sd(b + 1);
+	c01 = _mm256_fmadd_pd(a0, bj, c01);
+	c11 = _mm256_fmadd_pd(a1, bj, c11);
+	bj = _mm256_broadcast_sd(b + 2);
+	c02 = _mm256_fmadd_pd(a0, bj, c02);
+	c12 = _mm256_fmadd_pd(a1, bj, c12);
+	bj = _mm256_broadcast_sd(b + 3);
+	c03 = _mm256_fmadd_pd(a0, bj, c03);
+	c13 = _mm256_fmadd_pd(a1, bj, c13);
+	a += MR;
+	b += NR;
+    }
+    _mm256_storeu_pd(ab, c00);
+    _mm256_storeu_pd(ab + 4, c10);
+    _mm256_storeu_pd(ab + 8, c01);
+    _mm256_storeu_pd(ab + 12, c11);
+    _mm256_storeu_pd(ab + 16, c02);
+    _mm256_storeu_pd(ab + 20, c12);
+    _mm256_storeu_pd(ab + 24, c03);
+    _mm256_storeu_pd(ab + 28, c13);
+}
+#endif
+
+static microkernel_t select_microkernel(void)
+{
+#ifdef HAVE_AVX2_KERNEL
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	return microkernel_avx2;
+#endif
+    return microkernel_generic;
+}
+
+/* Element (i, p) of op(A), where op(A) is m x k. */
+#define OPA(A, lda, nota, i, p) \
+    ((nota) ? (A)[(i) + (size_t)(p) * (lda)] : (A)[(p) + (size_t)(i) * (lda)])
+
+/* Pack the mc x kc block of op(A) at (i0, p0) into MR-row slivers,
+ * zero-padding the last sliver. */
+static void pack_a(int nota, const double *A, int lda, int i0, int p0,
+		   int mc, int kc, double *dest)
+{
+    for (int ir = 0; ir < mc; ir += MR) {
+	int mr = (mc - ir < MR) ? mc - ir : MR;
+	for (int p = 0; p < kc; p++) {
+	    int i;
+	    for (i = 0; i < mr; i++)
+		dest[i] = OPA(A, lda, nota, i0 + ir + i, p0 + p);
+	    for (; i < MR; i++)
+		dest[i] = 0.0;
+	    dest += MR;
+	}
+    }
+}
+
+/* Pack the kc x nc block of op(B) at (p0, j0) into NR-column slivers,
+ * zero-padding the last sliver.  op(B) is k x n. */
+static void pack_b(int notb, const double *B, int ldb, int p0, int j0,
+		   int kc, int nc, double *dest)
+{
+    for (int jr = 0; jr < nc; jr += NR) {
+	int nr = (nc - jr < NR) ? nc - jr : NR;
+	for (int p = 0; p < kc; p++) {
+	    int j;
+	    for (j = 0; j < nr; j++)
+		dest[j] = notb ? B[p0 + p + (size_t)(j0 + jr + j) * ldb]
+		    : B[j0 + jr + j + (size_t)(p0 + p) * ldb];
+	    for (; j < NR; j++)
+		dest[j] = 0.0;
+	    dest += NR;
+	}
+    }
+}
+
+/* C[mc x nc] += alpha * Ap * Bp for packed panels. */
+static void macrokernel(microkernel_t kernel, int mc, int nc, int kc,
+			double alpha, const double *Ap, const double *Bp,
+			double *C, int ldc)
+{
+    double ab[MR * NR];
+    for (int jr = 0; jr < nc; jr += NR) {
+	int nr = (nc - jr < NR) ? nc - jr : NR;
+	for (int ir = 0; ir < mc; ir += MR) {
+	    int mr = (mc - ir < MR) ? mc - ir : MR;
+	    kernel(kc, Ap + (size_t) ir * kc, Bp + (size_t) jr * kc, ab);
+	    double *c = C + ir + (size_t) jr * ldc;
+	    for (int j = 0; j < nr; j++)
+		for (int i = 0; i < mr; i++)
+		    c[i + (size_t) j * ldc] += alpha * ab[i + j * MR];
+	}
+    }
+}
+
+/* C += alpha * op(A) * op(B) without any blocking, for small products
+ * or when the packing buffers cannot be allocated.  Loop order keeps
+ * the innermost access to C unit-stride. */
+static void gemm_simple(int nota, int notb, int m, int n, int k,
+			double alpha, const double *A, int lda,
+			const double *B, int ldb, double *C, int ldc)
+{
+    for (int j = 0; j < n; j++) {
+	double *cj = C + (size_t) j * ldc;
+	if (nota) {
+	    for (int p = 0; p < k; p++) {
+		double t = alpha * (notb ? B[p + (size_t) j * ldb]
+				    : B[j + (size_t) p * ldb]);
+		const double *ap = A + (size_t) p * lda;
+		for (int i = 0; i < m; i++)
+		    cj[i] += ap[i] * t;
+	    }
+	} else {
+	    for (int i = 0; i < m; i++) {
+		const double *ai = A + (size_t) i * lda;
+		double t = 0.0;
+		for (int p = 0; p < k; p++)
+		    t += ai[p] * (notb ? B[p + (size_t) j * ldb]
+				  : B[j + (size_t) p * ldb]);
+		cj[i] += alpha * t;
+	    }
+	}
+    }
+}
+
+/* C += alpha * op(A) * op(B), where op(A) is m x k and op(B) is k x n. */
+static void gemm_blocked(int nota, int notb, int m, int n, int k,
+			 double alpha, const double *A, int lda,
+			 const double *B, int ldb, double *C, int ldc)
+{
+    static microkernel_t kernel = NULL;
+    double work = (double) m * n * k;
+
+    if (work < SMALL_GEMM) {
+	gemm_simple(nota, notb, m, n, k, alpha, A, lda, B, ldb, C, ldc);
+	return;
+    }
+    if (!kernel)
+	kernel = select_microkernel();
+
+    int nthreads = 1;
+#ifdef _OPENMP
+    if (work >= PARALLEL_GEMM && !omp_in_parallel()) {
+	int nblocks = (m + MC - 1) / MC;
+	nthreads = omp_get_max_threads();
+	if (nthreads > nblocks)
+	    nthreads = nblocks;
+    }
+#endif
+
+    /* One B panel, shared, and one A panel per thread.  If the memory
+     * is not there, use fewer threads, and failing that no blocking. */
+    int ncmax = (n < NC) ? ((n + NR - 1) / NR) * NR : NC;
+    int kcmax = (k < KC) ? k : KC;
+    size_t asize = (size_t) MC * kcmax, bsize = (size_t) kcmax * ncmax;
+    double *buf;
+    while (!(buf = (double *) malloc((bsize + nthreads * asize)
+				     * sizeof(double)))) {
+	if (nthreads == 1) {
+	    gemm_simple(nota, notb, m, n, k, alpha, A, lda, B, ldb, C, ldc);
+	    return;
+	}
+	nthreads /= 2;
+    }
+    double *Bp = buf;
+
+    for (int j0 = 0; j0 < n; j0 += NC) {
+	int nc = (n - j0 < NC) ? n - j0 : NC;
+	for (int p0 = 0; p0 < k; p0 += KC) {
+	    int kc = (k - p0 < KC) ? k - p0 : KC;
+	    pack_b(notb, B, ldb, p0, j0, kc, nc, Bp);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+    schedule(dynamic)
+#endif
+	    for (int i0 = 0; i0 < m; i0 += MC) {
+		int mc = (m - i0 < MC) ? m - i0 : MC;
+		int tid = 0;
+#ifdef _OPENMP
+		tid = omp_get_thread_num();
+#endif
+		double *Ap = buf + bsize + tid * asize;
+		pack_a(nota, A, lda, i0, p0, mc, kc, Ap);
+		macrokernel(kernel, mc, nc, kc, alpha, Ap, Bp,
+			    C + i0 + (size_t) j0 * ldc, ldc);
+	    }
+	}
+    }
+    free(buf);
+}
+
+/* C := beta * C over the m x n block, honouring the BLAS convention
+ * that C need not be initialised when beta is zero. */
+static void scale_c(int m, int n, double beta, double *C, int ldc)
+{
+    if (beta == 1.0)
+	return;
+    for (int j = 0; j < n; j++) {
+	double *cj = C + (size_t) j * ldc;
+	if (beta == 0.0)
+	    for (int i = 0; i < m; i++) cj[i] = 0.0;
+	else
+	    for (int i = 0; i < m; i++) cj[i] *= beta;
+    }
+}
+
+static int upper_char(const char *c)
+{
+    return (*c >= 'a' && *c <= 'z') ? *c - 'a' + 'A' : *c;
+}
+
+void F77_NAME(dgemm)(const char *transa, const char *transb, const int *m,
+		     const int *n, const int *k, const double *alpha,
+		     const double *a, const int *lda,
+		     const double *b, const int *ldb,
+		     const double *beta, double *c, const int *ldc)
+{
+    int ta = upper_char(transa), tb = upper_char(transb);
+    int nota = (ta == 'N'), notb = (tb == 'N');
+    int nrowa = nota ? *m : *k, nrowb = notb ? *k : *n;
+    int info = 0;
+
+    if (!nota && ta != 'C' && ta != 'T')
+	info = 1;
+    else if (!notb && tb != 'C' && tb != 'T')
+	info = 2;
+    else if (*m < 0)
+	info = 3;
+    else if (*n < 0)
+	info = 4;
+    else if (*k < 0)
+	info = 5;
+    else if (*lda < (nrowa > 1 ? nrowa : 1))
+	info = 8;
+    else if (*ldb < (nrowb > 1 ? nrowb : 1))
+	info = 10;
+    else if (*ldc < (*m > 1 ? *m : 1))
+	info = 13;
+    if (info != 0) {
+	F77_CALL(xerbla)("DGEMM ", &info);
+	return;
+    }
+
+    if (*m == 0 || *n == 0
+	|| ((*alpha == 0.0 || *k == 0) && *beta == 1.0))
+	return;
+
+    scale_c(*m, *n, *beta, c, *ldc);
+    if (*alpha == 0.0 || *k == 0)
+	return;
+    gemm_blocked(nota, notb, *m, *n, *k, *alpha, a, *lda, b, *ldb, c, *ldc);
+}
+
+/* Diagonal blocks of DSYRK are computed in full into a scratch buffer
+ * of this order, and only the relevant triangle copied out. */
+#define SYRK_NB 256
+
+void F77_NAME(dsyrk)(const char *uplo, const char *trans,
+		     const int *n, const int *k,
+		     const double *alpha, const double *a, const int *lda,
+		     const double *beta, double *c, const int *ldc)
+{
+    int ul = upper_char(uplo), tr = upper_char(trans);
+    int upper = (ul == 'U'), notrans = (tr == 'N');
+    int nrowa = notrans ? *n : *k;
+    int info = 0;
+
+    if (!upper && ul != 'L')
+	info = 1;
+    else if (!notrans && tr != 'T' && tr != 'C')
+	info = 2;
+    else if (*n < 0)
+	info = 3;
+    else if (*k < 0)
+	info = 4;
+    else if (*lda < (nrowa > 1 ? nrowa : 1))
+	info = 7;
+    else if (*ldc < (*n > 1 ? *n : 1))
+	info = 10;
+    if (info != 0) {
+	F77_CALL(xerbla)("DSYRK ", &info);
+	return;
+    }
+
+    int N = *n, K = *k, LDA = *lda, LDC = *ldc;
+    double ALPHA = *alpha, BETA = *beta;
+    if (N == 0 || ((ALPHA == 0.0 || K == 0) && BETA == 1.0))
+	return;
+
+    /* Scale the referenced triangle of C by beta. */
+    if (BETA != 1.0) {
+	for (int j = 0; j < N; j++) {
+	    int i0 = upper ? 0 : j, i1 = upper ? j + 1 : N;
+	    scale_c(i1 - i0, 1, BETA, c + i0 + (size_t) j * LDC, LDC);
+	}
+    }
+    if (ALPHA == 0.0 || K == 0)
+	return;
+
+    /* C := C + alpha * op(A) * op(A)', where op(A) is n x k.  Column
+     * (row) i of op(A)' is the same as row (column) i of op(A), so with
+     * op(A) = A the second operand is A transposed, and vice versa. */
+    int nota = notrans, notb = !notrans;
+    double *diag = (double *) malloc((size_t) SYRK_NB * SYRK_NB
+				     * sizeof(double));
+    for (int j0 = 0; j0 < N; j0 += SYRK_NB) {
+	int nb = (N - j0 < SYRK_NB) ? N - j0 : SYRK_NB;
+	/* Offset of row/column j0 of op(A) within A. */
+	const double *aj = notrans ? a + j0 : a + (size_t) j0 * LDA;
+	/* Off-diagonal rectangle: rows [0, j0) for upper, [j0 + nb, N)
+	 * for lower. */
+	if (upper && j0 > 0)
+	    gemm_blocked(nota, notb, j0, nb, K, ALPHA, a, LDA, aj, LDA,
+			 c + (size_t) j0 * LDC, LDC);
+	else if (!upper && j0 + nb < N) {
+	    int r0 = j0 + nb;
+	    const double *ar = notrans ? a + r0 : a + (size_t) r0 * LDA;
+	    gemm_blocked(nota, notb, N - r0, nb, K, ALPHA, ar, LDA, aj, LDA,
+			 c + r0 + (size_t) j0 * LDC, LDC);
+	}
+	/* Diagonal block. */
+	double *cjj = c + j0 + (size_t) j0 * LDC;
+	if (diag) {
+	    memset(diag, 0, (size_t) nb * nb * sizeof(double));
+	    gemm_blocked(nota, notb, nb, nb, K, ALPHA, aj, LDA, aj, LDA,
+			 diag, nb);
+	    for (int j = 0; j < nb; j++) {
+		int i0 = upper ? 0 : j, i1 = upper ? j + 1 : nb;
+		for (int i = i0; i < i1; i++)
+		    cjj[i + (size_t) j * LDC] += diag[i + (size_t) j * nb];
+	    }
+	} else {
+	    /* No scratch space: one column at a time, straight into C. */
+	    for (int j = 0; j < nb; j++) {
+		int i0 = upper ? 0 : j, i1 = upper ? j + 1 : nb;
+		const double *ai = notrans ? aj + i0 : aj + (size_t) i0 * LDA;
+		const double *ajj = notrans ? aj + j : aj + (size_t) j * LDA;
+		gemm_simple(nota, notb, i1 - i0, 1, K, ALPHA, ai, LDA,
+			    ajj, LDA, cjj + i0 + (size_t) j * LDC, LDC);
+	    }
+	}
+    }
+    free(diag);
+}
@@ -42,6 +42,7 @@ extern "C" {
 #define EncodeElement       Rf_EncodeElement
 #define EncodeElement0      Rf_EncodeElement0
 #define EncodeEnvironment   Rf_EncodeEnvironment
+#define EncodeRealBuf       Rf_EncodeRealBuf
 #define printArray          Rf_printArray
 #define printMatrix         Rf_printMatrix
 #define printNamedVector    Rf_printNamedVector
@@ -70,6 +71,11 @@ void formatRaw(Rbyte *, R_xlen_t, int *);
 /* Formating of values */
 const char *EncodeElement0(SEXP, int, int, const char *);
 const char *EncodeEnvironment(SEXP);
+/* EncodeReal0() with a one-character 'dec', formatting into buff, which
+   must have room for R_ENCODE_REAL_BUFSIZE chars.  Unlike EncodeReal0()
+   this uses no static storage, so may be called by several threads. */
+#define R_ENCODE_REAL_BUFSIZE 1000
+void EncodeRealBuf(char *buff, double x, int w, int d, int e, char cdec);
 /* Legacy, for R.app */
 const char *EncodeElement(SEXP, int, int, char);
 
@@ -0,0 +1,140 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file AllocationProfiler.hpp
+ *
+ * @brief Class rho::AllocationProfiler.
+ */
+
+#ifndef RHO_ALLOCATIONPROFILER_HPP
+#define RHO_ALLOCATIONPROFILER_HPP
+
+#include <cstddef>
+#include <cstdio>
+
+namespace rho {
+    class GCNode;
+
+    /** @brief Sampling profiler of memory allocation.
+     *
+     * While the profiler is running, it samples allocations made
+     * through GCNode::operator new and MemoryBank::allocate(), on
+     * average one for every \a interval bytes requested.  The gaps
+     * between samples are drawn from an exponential distribution,
+     * so that every byte allocated is equally likely to be sampled
+     * whatever the pattern of allocation sizes, and each sample is
+     * weighted to give unbiased estimates of the number of objects
+     * and bytes allocated.
+     *
+     * For each sample the profiler records the R call stack, taken
+     * from the chain of Evaluator::Context objects; the type of
+     * object allocated, which is its SEXPTYPE if it is an RObject,
+     * the name of its C++ class if it is some other GCNode, and
+     * "(block)" for memory from MemoryBank::allocate(); and its
+     * size class.  Samples that agree in all three are aggregated,
+     * and writeProfile() writes the totals in the protocol buffer
+     * format read by pprof.
+     *
+     * An object's type is not known when its memory is allocated,
+     * so a sampled GCNode is examined later: at the next sample, at
+     * the start of the next garbage collection, or when the
+     * profiler is stopped, whichever comes first.
+     */
+    class AllocationProfiler {
+    public:
+	/** @brief Is the profiler running?
+	 */
+	static bool isRunning()
+	{
+	    return s_running;
+	}
+
+	/** @brief Discard any existing profile and start sampling.
+	 *
+	 * @param interval Mean number of bytes allocated between
+	 *          samples.  Must be at least 1.
+	 */
+	static void start(double interval);
+
+	/** @brief Stop sampling.
+	 *
+	 * The profile collected so far is kept until the profiler is
+	 * next started.
+	 */
+	static void stop();
+
+	/** @brief Write out the profile.
+	 *
+	 * @param file Stream, opened in binary mode, to which the
+	 *          profile is written as a serialized
+	 *          perftools.profiles.Profile message.
+	 *
+	 * @return true iff the profile was written without error.
+	 */
+	static bool writeProfile(std::FILE* file);
+
+	/** @brief Attribute any sampled GCNode still awaiting a type.
+	 *
+	 * Called by GCManager before a garbage collection, which
+	 * might otherwise free the node first.
+	 */
+	static void resolvePending()
+	{
+	    if (s_pending_node)
+		resolvePendingNode(false);
+	}
+    private:
+	friend class GCNode;
+	friend class MemoryBank;
+
+	static bool s_running;
+	// Bytes still to be allocated before the next sample.
+	static std::ptrdiff_t s_countdown;
+	static const GCNode* s_pending_node;
+
+	// Called by MemoryBank for every block allocated; node is the
+	// address of the GCNode being allocated, or null.
+	static void notifyAllocation(std::size_t bytes, const GCNode* node)
+	{
+	    s_countdown -= std::ptrdiff_t(bytes);
+	    if (s_countdown < 0)
+		sample(bytes, node);
+	}
+
+	// Called by GCNode::operator delete.
+	static void notifyDeallocation(const void* p)
+	{
+	    if (p == s_pending_node)
+		resolvePendingNode(true);
+	}
+
+	static void sample(std::size_t bytes, const GCNode* node);
+
+	// If freed is true the node's type can no longer be found.
+	static void resolvePendingNode(bool freed);
+
+	AllocationProfiler() = delete;
+    };
+}  // namespace rho
+
+#endif  // RHO_ALLOCATIONPROFILER_HPP
@@ -459,7 +459,25 @@ namespace rho {
 	void wrapInPromises(Environment* env,
 			    const Expression* call = nullptr);
 
+	/** @brief Prepare the arguments of a closure call.
+	 *
+	 * This is like wrapInPromises(), except that arguments for
+	 * which Promise::isConstant() is true are left as they are,
+	 * rather than being wrapped in Promise objects.  Code that
+	 * matches the result to formal arguments must therefore not
+	 * assume that every argument is a Promise.
+	 *
+	 * @param env As for wrapInPromises().
+	 *
+	 * @param call As for wrapInPromises().
+	 */
+	void wrapInPromisesForClosure(Environment* env,
+				      const Expression* call = nullptr);
+
     private:
+	void wrapInPromises(Environment* env, const Expression* call,
+			    bool wrap_constants);
+
 	const PairList* const m_orig_list;  // Pointer to the argument
 	  // list supplied to the constructor. 
 	GCStackRoot<PairList> m_list;  // The current argument list. The
@@ -209,9 +209,13 @@ namespace rho {
 	 * calls to match() that use arglist with the same tags as \a args,
 	 * resulting in dramatically faster matching.
 	 *
-	 * This function returns nullptr if the matching can't be cached (e.g.
-	 * because \a args contains <tt>...</tt> and throws an error if the
-	 * arguments don't match this matcher's formals.
+	 * This function returns nullptr if the matching can't be cached
+	 * (i.e. if \a args still contains an unexpanded <tt>...</tt>) and
+	 * throws an error if the arguments don't match this matcher's
+	 * formals.  An ArgList to which ArgList::wrapInPromises() has been
+	 * applied has had any <tt>...</tt> expanded, so can always be
+	 * cached; the result then applies to calls whose arguments have
+	 * the same tags after expansion.
 	 *
 	 * @param args An arglist with the pattern of tags to match against.
 	 *           The values of the arguments are ignored.
@@ -154,9 +154,37 @@ namespace rho {
 	}
 
 	/** @brief Create an environment suitable for evaluating this closure.
+	 *
+	 * If a previous application of the closure left behind an
+	 * Environment cleared for reuse (see recycleExecutionEnv()),
+	 * that Environment is returned.
 	 */
         Environment* createExecutionEnv() const;
 
+	/** @brief Keep a local Environment for reuse, if safe.
+	 *
+	 * This function is called when an application of this
+	 * Closure returns normally.  If no Environment is already
+	 * being kept, and Environment::clearForReuse() succeeds on \a
+	 * env, then \a env is kept for the next call to
+	 * createExecutionEnv().
+	 *
+	 * @param env Non-null pointer to the Environment created for
+	 *          the application by createExecutionEnv().
+	 *
+	 * @param result Pointer, possibly null, to the value returned
+	 *          by the application.
+	 *
+	 * @return true iff \a env has been kept.
+	 */
+	bool recycleExecutionEnv(Environment* env, const RObject* result) const
+	{
+	    if (m_spare_env || !env->clearForReuse(result))
+		return false;
+	    m_spare_env = env;
+	    return true;
+	}
+
 	/** @brief Set debugging status.
 	 *
 	 * @param on The required new debugging status (true =
@@ -277,6 +305,8 @@ namespace rho {
 	GCEdge<const ArgMatcher> m_matcher;
 	GCEdge<> m_body;
 	GCEdge<Environment> m_environment;
+	mutable GCEdge<Environment> m_spare_env;  // Local environment
+	  // cleared for reuse, or null.
         static bool s_debugging_enabled;
 
 	// If a JIT compiled version of this closure exists, invalidate it.
@@ -352,6 +352,32 @@ namespace rho {
 #endif
 	}
 
+	/** @brief Clear the local Environment of a Closure call for
+	 *  reuse, if safe.
+	 *
+	 * This function is called on the local Environment of a
+	 * Closure when the application of the Closure returns
+	 * normally.  If the Environment can no longer be reached, its
+	 * Frame is cleared, so that the Environment can serve as the
+	 * local Environment of a later application of the Closure
+	 * instead of a newly allocated one.
+	 *
+	 * The test is conservative.  The Environment must not be \a
+	 * result, nor have been marked as leaked; and neither it nor
+	 * its Frame may be designated by any GCEdge or GCRoot other
+	 * than the one linking the two, so that for example any
+	 * Promise or Closure created during the call, and still
+	 * referring to the Environment, prevents reuse.  Only
+	 * Environments with an unlocked and unmonitored ListFrame, and
+	 * no attributes, are reused.
+	 *
+	 * @param result Pointer, possibly null, to the value returned
+	 *          by the Closure call.
+	 *
+	 * @return true iff the Environment has been cleared for reuse.
+	 */
+	bool clearForReuse(const RObject* result);
+
 	/** @brief Look for Environment objects that may have
 	 *  'leaked'.
 	 *
@@ -489,7 +515,8 @@ namespace rho {
 	};
 
 	// The class maintains a cache of Symbol Bindings found along
-	// the search path:
+	// the search path.  A null Binding pointer records that the
+	// Symbol is not bound anywhere on the search path:
         class Cache;
 	static Cache* searchPathCache();
         static Cache* createSearchPathCache();
@@ -84,10 +84,14 @@ namespace rho {
 	 * classes.  This base class contains a type field to allow
 	 * Context types to be distinguished without the overhead of a
 	 * \c dynamic_cast .
+	 *
+	 * FunctionContext::innermost() relies on FUNCTION and CLOSURE
+	 * being the last (and only the last) enumerators.
 	 */
 	enum Type {
 	    BAILOUT = 0, /**< Context understanding Bailout objects. */
 	    PLAIN,       /**< Lightweight Context neutralising BailoutContext. */
+	    COMPILED,    /**< As PLAIN, around JIT-compiled code. */
 	    FUNCTION,    /**< Context corresponding to a BuiltInFunction. */
 	    CLOSURE      /**< Context corresponding to a Closure. */
 	};
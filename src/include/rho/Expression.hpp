@@ -31,6 +31,7 @@
 #ifndef EXPRESSION_H
 #define EXPRESSION_H
 
+#include <memory>
 #include "rho/FunctionBase.hpp"
 #include "rho/PairList.hpp"
 
@@ -215,6 +216,10 @@ namespace rho {
      *
      * Unlike the regular Expression class, this class caches the results of
      * parameter matching to closure calls for improved performance.
+     * Matching is cached on the tags of the arguments after any
+     * <tt>...</tt> has been expanded, and a few results are kept, so
+     * that a call such as <tt>f(x, ...)</tt> within a wrapper function
+     * benefits even if the wrapper is called in several different ways.
      */
     class CachingExpression : public Expression {
     public:
@@ -262,10 +267,24 @@ namespace rho {
 	// Object used for recording details from previous evaluations of
 	// this expression, for the purpose of optimizing future evaluations.
 	// In the future, this will likely include type recording as well.
-        mutable struct {
-	    GCEdge<const FunctionBase> m_function;
-            const ArgMatchInfo* m_arg_match_info;
-	} m_cache;
+	// Allocated when the expression first calls a closure.
+	struct Cache {
+	    // Each entry is valid for calls of one closure with the same
+	    // sequence of argument tags, counted after '...' has been
+	    // expanded.  A call that passes on '...' can present a
+	    // different sequence each time, so several are kept.  Once
+	    // all are in use, further combinations are matched in full.
+	    enum { NUM_ENTRIES = 4 };
+
+	    struct Entry {
+		GCEdge<const FunctionBase> m_function;
+		const ArgMatchInfo* m_arg_match_info;
+	    };
+
+	    Entry m_entries[NUM_ENTRIES];
+	    unsigned int m_num_entries = 0;
+	};
+	mutable std::unique_ptr<Cache> m_cache;
 
 	void matchArgsIntoEnvironment(const Closure* func,
 				      Environment* calling_env,
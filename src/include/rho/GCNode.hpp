@@ -233,6 +233,19 @@ namespace rho {
 	 */
 	virtual void visitReferents(const_visitor* v) const {}
 
+	/** @brief Number of counted references to this node.
+	 *
+	 * @return The number of references to this node from GCEdge
+	 * and GCRoot objects and the PROTECT stack.  The count
+	 * saturates, and pointers held on the processor stack are not
+	 * counted, so a count of zero does not by itself imply that the
+	 * node is garbage.
+	 */
+	unsigned int referenceCount() const
+	{
+	    return getRefCount();
+	}
+
 	// If candidate_pointer is a (possibly internal) pointer to a GCNode,
 	// returns the pointer to that node.
 	// Otherwise returns nullptr.
@@ -70,6 +70,47 @@ namespace rho {
       typedef IntVector type;
     };
 
+    /** @brief Shared length-one integer vectors.
+     *
+     * Scalar arithmetic creates a great many short-lived length-one
+     * vectors.  Those holding a small integer are instead taken from
+     * this table of immutable vectors, in the way that
+     * Rf_ScalarLogical() shares R_TrueValue and its fellows.
+     */
+    struct SmallIntVectors {
+	static const int s_min = -128;
+	static const int s_max = 1023;
+
+	// Null until initialize() has been called.
+	static IntVector* s_table[s_max - s_min + 1];
+
+	static void initialize();
+
+	/** @brief The shared vector holding \a value, if there is one.
+	 *
+	 * @return Pointer to an immutable IntVector of length one
+	 *         containing \a value, or a null pointer if \a value is
+	 *         outside the table.
+	 */
+	static IntVector* lookup(int value)
+	{
+	    if (value < s_min || value > s_max)
+		return nullptr;
+	    return s_table[value - s_min];
+	}
+    };
+
+    template<>
+    template<typename U>
+    IntVector* IntVector::createScalar(const U& value) {
+	int int_value = value;
+	if (IntVector* shared = SmallIntVectors::lookup(int_value))
+	    return shared;
+	IntVector* result = create(1);
+	(*result)[0] = int_value;
+	return result;
+    }
+
 }  // namespace rho
 
 extern "C" {
@@ -32,9 +32,9 @@
 #ifndef LISTFRAME_HPP
 #define LISTFRAME_HPP
 
-#include <unordered_map>
+#include <cstdint>
+#include <vector>
 
-#include "rho/Allocator.hpp"
 #include "rho/Frame.hpp"
 
 namespace rho {
@@ -47,12 +47,20 @@ namespace rho {
      * For large numbers of bindings, lookups and insertions are still O(1),
      * but not as fast.
      *
-     * This is implemented via a fixed-size unordered array of bindings.
-     * For small sizes, the linear scan through the array is fast and cache
-     * efficient.
-     * If more bindings are added to the frame than the array can store,
-     * the remaining bindings are added to a hashmap.  This ensures that
-     * the frame can handle large numbers of bindings reasonably efficiently.
+     * Bindings are held in a fixed-size array, alongside a parallel
+     * array of the Symbols bound.  The first few slots of the array
+     * lie within the ListFrame object itself, which suffices for the
+     * frames of typical function calls; any further slots are
+     * allocated separately when the frame is created.  For
+     * small sizes, a linear scan of the Symbols is fast and cache
+     * efficient.  Bindings that do not fit in the array are held in
+     * separately allocated blocks.  Once a frame holds more than a
+     * few Bindings, they are all indexed by an open-addressing hash
+     * table using Robin Hood insertion, and lookups use the table.
+     *
+     * Bindings never move once created, as there is a bunch of code
+     * (most notably the search path cache) that keeps pointers to
+     * them.
      */
     class ListFrame : public Frame {
     public:
@@ -69,29 +77,42 @@ namespace rho {
 
     protected:
 
-	// The main array that bindings are stored in.
-	// Note that the array cannot be moved or expanded, as there is a
-	// bunch of code (most notably the global cache) that keeps pointers
-	// to bindings.
-	Binding* m_bindings;
+	// The main array that bindings are stored in, and the symbols
+	// to which its slots are assigned (null for a free slot), are
+	// each held in two segments: the first kDefaultListSize slots
+	// within the ListFrame object, and the rest, if any, in
+	// m_heap_bindings and m_heap_symbols.  A slot is assigned to a
+	// symbol before the Binding in it is initialized.
 	size_t m_bindings_size;
-	size_t m_used_bindings_size;
-	
-	// The default size of the array to create.
-	static const size_t kDefaultListSize = 16;
-	// The largest array to create.  Since the array must be searched
-	// with a linear scan, we don't want to allow it to get too big.
+	size_t m_used_bindings_size;  // Slots beyond this are free.
+
+	// The default size of the array to create, which is also the
+	// number of slots held within the ListFrame object.
+	static const size_t kDefaultListSize = 8;
+	// The largest array to create.  Bindings beyond this are held
+	// in the overflow blocks.
 	static const size_t kMaxListSize = 64;
+	// Frames with more assigned slots than this are indexed.
+	static const size_t kIndexThreshold = 16;
+
+	// A slot outside the main array.
+	struct OverflowSlot {
+	    const Symbol* symbol;  // Null if free.
+	    Binding binding;
+	};
 
-	// Used to store any bindings that don't fit in m_bindings.
-	// Usually this is nullptr.
-	typedef std::unordered_map<const Symbol*, Binding,
-				   std::hash<const Symbol*>,
-				   std::equal_to<const Symbol*>,
-				   rho::Allocator<std::pair<const Symbol* const,
-							    Binding>>>
-	    map;
-	map* m_overflow;
+	// Blocks of OverflowSlots, each twice the size of the last, and
+	// the slots in them that have been freed.  Usually empty.
+	std::vector<OverflowSlot*> m_overflow;
+	std::vector<OverflowSlot*> m_overflow_free;
+	size_t m_overflow_used;  // Slots used in the last block.
+
+	// Open-addressing hash table of all the assigned slots, or null
+	// if the frame has not yet needed one.
+	class Index;
+	Index* m_index;
+
+	size_t m_num_assigned;  // Number of slots assigned to a symbol.
 
 	// Declared protected to ensure that ListFrame objects are
 	// created only using 'new':
@@ -103,15 +124,48 @@ namespace rho {
 	{
 	    return binding.frame() != nullptr;
 	}
+
+	// Slot 'index' of the main array.
+	Binding* slotBinding(size_t index)
+	{
+	    return (index < kDefaultListSize ? &m_inline_bindings[index]
+		    : &m_heap_bindings[index - kDefaultListSize]);
+	}
+
+	// The symbol to which slot 'index' of the main array is
+	// assigned, or null.
+	const Symbol*& slotSymbol(size_t index)
+	{
+	    return (index < kDefaultListSize ? m_inline_symbols[index]
+		    : m_heap_symbols[index - kDefaultListSize]);
+	}
 	
 	static void unsetBinding(Binding* binding);
 
+	// Assign slot 'index' of the main array to 'symbol'.
+	Binding* assignSlot(size_t index, const Symbol* symbol);
+
+	// Assign a slot outside the main array to 'symbol'.
+	Binding* assignOverflowSlot(const Symbol* symbol);
+
+	// The slot assigned to 'symbol', whether or not its Binding has
+	// been initialized, or null.
+	Binding* findSlot(const Symbol* symbol);
+
 	// Virtual functions of Frame (qv):
 	void v_clear() override;
 	bool v_erase(const Symbol* symbol) override;
 	Binding* v_obtainBinding(const Symbol* symbol) override;
 	Binding* v_binding(const Symbol* symbol) override;
 	const Binding* v_binding(const Symbol* symbol) const override;
+    private:
+	Binding m_inline_bindings[kDefaultListSize];
+	const Symbol* m_inline_symbols[kDefaultListSize];
+	Binding* m_heap_bindings;  // Null unless m_bindings_size is larger.
+	const Symbol** m_heap_symbols;
+
+	void buildIndex();
+	void freeSlot(Binding* binding);
     };
 }  // namespace rho
 #endif // LISTFRAME_HPP
@@ -38,6 +38,8 @@
 #define ALLOC_STATS // TODO(joqvist): Make this a configure option?
 
 namespace rho {
+    class GCNode;
+
     /** @brief Class to manage memory allocation and deallocation for rho.
      * 
      * Small objects are quickly allocated from pools of various cell
@@ -144,7 +146,9 @@ namespace rho {
 #endif
 
 	friend class GCNode;
-	static void notifyAllocation(size_t bytes);
+	// node is the GCNode being allocated, if any, for the benefit of
+	// AllocationProfiler.
+	static void notifyAllocation(size_t bytes, const GCNode* node = nullptr);
 
 	static void notifyDeallocation(size_t bytes);
 
@@ -48,6 +48,19 @@ namespace rho {
 	    setType(PLAIN);
 	}
     };
+
+    /** @brief PlainContext around the execution of JIT-compiled code.
+     *
+     * This behaves exactly as a PlainContext, but tells the
+     * sampling profiler that the Closure most narrowly enclosing it
+     * is running compiled code.
+     */
+    struct CompiledCodeContext : Evaluator::Context {
+	CompiledCodeContext()
+	{
+	    setType(COMPILED);
+	}
+    };
 }  // namespace rho
 
 #endif  // PLAINCONTEXT_HPP
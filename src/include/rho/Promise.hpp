@@ -94,6 +94,33 @@ namespace rho {
 	    return result;
 	}
 
+	/** @brief Does an expression need a Promise?
+	 *
+	 * @param expression Pointer, possibly null, to an argument
+	 *          expression or default value.
+	 *
+	 * @return true iff \a expression is NULL or a vector of one of
+	 *         the atomic types.  Evaluating such an expression
+	 *         yields the expression itself, has no side effects and
+	 *         cannot fail, so it can stand for its own Promise.
+	 */
+	static bool isConstant(const RObject* expression)
+	{
+	    if (!expression)
+		return true;
+	    switch (expression->sexptype()) {
+	    case LGLSXP:
+	    case INTSXP:
+	    case REALSXP:
+	    case CPLXSXP:
+	    case STRSXP:
+	    case RAWSXP:
+		return true;
+	    default:
+		return false;
+	    }
+	}
+
 	/** @brief Access the environment of the Promise.
 	 *
 	 * @return Pointer to the environment of the Promise.  This
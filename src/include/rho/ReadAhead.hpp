@@ -0,0 +1,178 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/** @file ReadAhead.hpp
+ *
+ * @brief Class rho::ReadAhead.
+ */
+
+#ifndef RHO_READAHEAD_HPP
+#define RHO_READAHEAD_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rho {
+    /** @brief Background reading of a byte stream.
+     *
+     * A ReadAhead runs a thread of its own that calls a source
+     * function to fill a small ring of blocks, while the R thread
+     * consumes earlier blocks with read() and getc().  Connections
+     * use it so that reading a file, and decompressing it, overlap
+     * with the evaluation of R code that uses the data.
+     *
+     * The source runs on the background thread, so the rules of
+     * ThreadPool apply to it: it must not touch the R heap or raise R
+     * errors or warnings.  Nor may anything else use the underlying
+     * stream until the ReadAhead has been destroyed.
+     *
+     * fork() waits until no call of a source is in progress, and
+     * then stops reading ahead in both processes.  Each keeps the
+     * blocks read so far, and afterwards calls the source itself only
+     * when asked for more, so that neither reads from a file offset
+     * shared with the other unless R code asks it to.  A source
+     * should not block indefinitely, as a read from a pipe might.
+     */
+    class ReadAhead {
+    public:
+	/** @brief Function that supplies the data.
+	 *
+	 * Called as source(buf, n) to read up to \a n bytes into \a
+	 * buf.  It returns the number of bytes read, 0 at the end of
+	 * the stream, or -1 if an error stops reading.
+	 */
+	typedef std::function<std::ptrdiff_t(void*, std::size_t)> Source;
+
+	/** @brief Start reading ahead.
+	 *
+	 * @param source Function that supplies the data.
+	 *
+	 * @param block_size Most bytes requested from \a source at
+	 *          once.
+	 *
+	 * @param nblocks Most blocks read but not yet consumed.
+	 */
+	explicit ReadAhead(Source source, std::size_t block_size = 1 << 18,
+			   std::size_t nblocks = 4);
+
+	/** @brief Stop the background thread.
+	 *
+	 * Any data read ahead but not consumed are discarded.
+	 */
+	~ReadAhead();
+
+	/** @brief Bytes consumed so far.
+	 *
+	 * @return The number of bytes returned by read() and getc(),
+	 * which is the position in the stream as seen by the reader.
+	 */
+	double consumed() const
+	{
+	    return m_consumed;
+	}
+
+	/** @brief Did an error stop reading?
+	 *
+	 * @return true iff the source returned -1, and the data before
+	 * the error have all been consumed.
+	 */
+	bool failed() const
+	{
+	    return m_at_end && m_failed;
+	}
+
+	/** @brief Next byte of the stream.
+	 *
+	 * @return The byte, or -1 if the end of the stream has been
+	 * reached.
+	 */
+	int getc()
+	{
+	    if (m_pos == m_current.size() && !nextBlock())
+		return -1;
+	    ++m_consumed;
+	    return static_cast<unsigned char>(m_current[m_pos++]);
+	}
+
+	/** @brief Read from the stream.
+	 *
+	 * @param buf Where to put the data.
+	 *
+	 * @param n Number of bytes wanted.
+	 *
+	 * @return The number of bytes read, which is less than \a n
+	 * only at the end of the stream.
+	 */
+	std::size_t read(void* buf, std::size_t n);
+    private:
+	Source m_source;
+	std::size_t m_block_size;
+	std::size_t m_max_blocks;
+
+	// Shared with the background thread, and protected by m_mutex.
+	std::mutex m_mutex;
+	std::condition_variable m_filled;
+	std::condition_variable m_drained;
+	std::deque<std::vector<char>> m_full;
+	std::vector<std::vector<char>> m_spare;
+	bool m_eof;
+	bool m_failed;
+	bool m_stopping;
+	bool m_reading;  // A call of m_source is in progress.
+
+	// Used only by the reader.
+	std::vector<char> m_current;
+	std::size_t m_pos;
+	bool m_at_end;
+	double m_consumed;
+
+	// Null if the reader calls the source itself: if the thread
+	// could not be started, or after a fork().  The
+	// pthread_atfork() handlers hold m_mutex of every ReadAhead
+	// across the fork, once no block is being read, and then stop
+	// the thread in the parent.  The child never had it.
+	std::thread* m_thread;
+
+	ReadAhead(const ReadAhead&) = delete;
+	ReadAhead& operator=(const ReadAhead&) = delete;
+
+	// Make the next block current.  Returns false at the end of
+	// the stream.
+	bool nextBlock();
+
+	// Body of the background thread.
+	void fill();
+
+	// pthread_atfork() handlers.
+	static void prepareFork();
+	static void parentAfterFork();
+	static void childAfterFork();
+    };
+}  // namespace rho
+
+#endif  // RHO_READAHEAD_HPP
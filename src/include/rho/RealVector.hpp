@@ -75,6 +75,49 @@ namespace rho {
       typedef RealVector type;
     };
 
+    /** @brief Shared length-one real vectors.
+     *
+     * The counterpart of SmallIntVectors for real vectors holding a
+     * small whole number.  Negative zero is not shared, so that the
+     * sign of a zero result is preserved.
+     */
+    struct SmallRealVectors {
+	static const int s_min = -128;
+	static const int s_max = 1023;
+
+	// Null until initialize() has been called.
+	static RealVector* s_table[s_max - s_min + 1];
+
+	static void initialize();
+
+	/** @brief The shared vector holding \a value, if there is one.
+	 *
+	 * @return Pointer to an immutable RealVector of length one
+	 *         containing \a value, or a null pointer if \a value is
+	 *         not a whole number within the table.
+	 */
+	static RealVector* lookup(double value)
+	{
+	    if (!(value >= s_min && value <= s_max))
+		return nullptr;
+	    int int_value = int(value);
+	    if (value != int_value || (value == 0 && std::signbit(value)))
+		return nullptr;
+	    return s_table[int_value - s_min];
+	}
+    };
+
+    template<>
+    template<typename U>
+    RealVector* RealVector::createScalar(const U& value) {
+	double real_value = value;
+	if (RealVector* shared = SmallRealVectors::lookup(real_value))
+	    return shared;
+	RealVector* result = create(1);
+	(*result)[0] = real_value;
+	return result;
+    }
+
 }  // namespace rho
 
 extern "C" {
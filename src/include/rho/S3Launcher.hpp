@@ -29,8 +29,12 @@
 #ifndef S3LAUNCHER_HPP
 #define S3LAUNCHER_HPP 1
 
-#include "rho/GCNode.hpp"
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "rho/GCNode.hpp"
+#include "rho/GCRoot.hpp"
 #include "rho/StringVector.hpp"
 
 namespace rho {
@@ -263,6 +267,25 @@ namespace rho {
 	  // default method.
 	bool m_using_group;  // True iff 'function' is a group method.
 
+	// The Symbols naming the methods sought when dispatching on a
+	// particular vector of classes:
+	struct MethodNames {
+	    std::string generic;
+	    std::string group;
+	    GCRoot<const StringVector> classes;  // Private copy.
+	    std::vector<Symbol*> generic_methods;  // generic.class
+	    std::vector<Symbol*> group_methods;  // group.class, if any group
+	    Symbol* default_method;  // generic.default
+	};
+
+	// Return the MethodNames for dispatching generic (and group) on
+	// classes.  Recently used MethodNames are cached, which saves
+	// building and looking up each method name anew in calls in a
+	// loop.
+	static std::shared_ptr<const MethodNames>
+	methodNames(const std::string& generic, const std::string& group,
+		    const StringVector* classes);
+
 	S3Launcher(const std::string& generic, const std::string& group,
 		   Environment* call_env, Environment* table_env)
 	    : m_generic(generic), m_group(group), m_using_group(false)
@@ -0,0 +1,126 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file ThreadPool.hpp
+ *
+ * @brief Class rho::ThreadPool.
+ */
+
+#ifndef RHO_THREADPOOL_HPP
+#define RHO_THREADPOOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+namespace rho {
+    /** @brief Worker threads for data-parallel kernels.
+     *
+     * R code is evaluated on a single thread, and nothing that
+     * touches the R heap is thread-safe.  ThreadPool lets kernels
+     * that work on raw buffers (the contents of a RealVector, say,
+     * or a block of bytes read from a file) spread that work over
+     * several cores.
+     *
+     * Tasks run on the pool must therefore not allocate GCNode
+     * objects, create GCRoot or GCStackRoot objects, call into the
+     * Evaluator, or raise R errors or warnings.  A C++ exception
+     * thrown by a task is caught, and the first such exception is
+     * rethrown on the calling thread once all tasks have finished.
+     *
+     * The number of threads used is set by initialize() from the
+     * environment variable OMP_NUM_THREADS, or else the number of
+     * hardware threads.  It is independent of R_num_math_threads.
+     * Requests made from within a task are run inline, as are all
+     * requests when only one thread is allowed.
+     */
+    class ThreadPool {
+    public:
+	/** @brief Set the default number of threads.
+	 *
+	 * Called once, during R startup.
+	 */
+	static void initialize();
+
+	/** @brief Number of threads available to a parallel operation.
+	 *
+	 * @return The number of threads, including the calling
+	 * thread, that run() may use.  Always at least 1.
+	 */
+	static unsigned int numThreads();
+
+	/** @brief Run a set of tasks, possibly concurrently.
+	 *
+	 * @param ntasks Number of tasks.
+	 *
+	 * @param task Function to be called once for each integer in
+	 *          the range [0, \a ntasks), in no particular order
+	 *          and possibly concurrently.  The calling thread
+	 *          participates.
+	 *
+	 * Returns once every task has completed.
+	 */
+	static void run(std::size_t ntasks,
+			const std::function<void(std::size_t)>& task);
+
+	/** @brief Split a range of indices between threads.
+	 *
+	 * @param n Size of the range [0, \a n).
+	 *
+	 * @param grain The smallest number of indices worth handing
+	 *          to a thread of its own.
+	 *
+	 * @param body Function object called as body(begin, end) on
+	 *          disjoint subranges that together cover [0, \a n).
+	 *          If the range is not worth splitting, \a body is
+	 *          called once, on the calling thread, with the whole
+	 *          range.
+	 */
+	template <typename F>
+	static void parallelFor(std::size_t n, std::size_t grain, F body)
+	{
+	    std::size_t nthreads = numThreads();
+	    std::size_t nchunks
+		= std::min(4*nthreads, n/std::max(grain, std::size_t(1)));
+	    if (nthreads <= 1 || nchunks <= 1 || inWorker()) {
+		if (n > 0)
+		    body(std::size_t(0), n);
+		return;
+	    }
+	    run(nchunks, [&](std::size_t chunk) {
+		    body(chunk*n/nchunks, (chunk + 1)*n/nchunks);
+		});
+	}
+
+	/** @brief Is the calling thread running a pool task?
+	 *
+	 * @return true iff the calling thread is one of the pool's
+	 * worker threads, or is itself executing tasks within run().
+	 */
+	static bool inWorker();
+    private:
+	ThreadPool() = delete;
+    };
+}  // namespace rho
+
+#endif  // RHO_THREADPOOL_HPP
@@ -51,7 +51,7 @@ public:
     {
     	assert(location >= 0);
     	assert(location < m_descriptor->getNumberOfSymbols());
-    	Binding* binding = m_bindings + location;
+    	Binding* binding = slotBinding(location);
     	if (isSet(*binding)) {
     	    return binding;
     	} else {
@@ -68,8 +68,10 @@ public:
     {
     	assert(location >= 0);
     	assert(location < m_descriptor->getNumberOfSymbols());
-    	Binding* binding = m_bindings + location;
+    	Binding* binding = slotBinding(location);
     	if (!isSet(*binding)) {
+	    if (!slotSymbol(location))
+		assignSlot(location, symbol);
 	    initializeBinding(binding, symbol);
 	}
 	return binding;
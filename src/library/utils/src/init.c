@@ -78,8 +78,9 @@ static const R_ExternalMethodDef ExtEntries[] = {
     EXTDEF(download, 5),
 #endif
     EXTDEF(unzip, 7),
-    EXTDEF(Rprof, 8),
+    EXTDEF(Rprof, 10),
     EXTDEF(Rprofmem, 3),
+    EXTDEF(Rprofalloc, 2),
 
     EXTDEF(countfields, 6),
     EXTDEF(readtablehead, 7),
@@ -41,7 +41,12 @@
 #include <Print.h>
 
 #include <rlocale.h> /* for btowc */
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
 #include "rho/IntVector.hpp"
+#include "rho/ThreadPool.hpp"
 
 #undef _
 #ifdef ENABLE_NLS
@@ -539,6 +544,49 @@ static void ruleout_types(const char *s, Typecvt_Info *typeInfo, LocalData *data
 }
 
 
+/* Long columns are parsed by the threads of rho::ThreadPool.  The
+   elements that count as NA are found first, on the calling thread;
+   the workers see only C strings.  Each worker stops at the first
+   element its parser rejects, and typeconvert() resumes its serial
+   loop at the earliest of these, so that the result, and the types
+   ruled out, are just as if the whole column had been done serially.
+*/
+#define TYPECONVERT_PARALLEL_MIN 20000
+#define TYPECONVERT_GRAIN 4096
+
+/* Is s empty apart from ASCII white space?  Unlike isBlankString()
+   this cannot raise an error, so is safe in a worker. */
+static R_INLINE Rboolean isASCIIBlank(const char *s)
+{
+    for (; *s; s++)
+	if ((unsigned char) *s >= 0x80 || !isspace(*s)) return FALSE;
+    return TRUE;
+}
+
+/* Parses fields into out until parse() rejects one; null fields are
+   NA.  Returns the index of the rejected field, or the number of
+   fields.  All earlier elements of out have been set. */
+template <typename T, typename Parse>
+static size_t convert_fields(const std::vector<const char *> &fields,
+			     T *out, T na, Parse parse)
+{
+    std::atomic<size_t> stop(fields.size());
+    rho::ThreadPool::parallelFor(
+	fields.size(), TYPECONVERT_GRAIN, [&](size_t b, size_t e) {
+	    for (size_t k = b; k < e; k++) {
+		size_t s = stop.load(std::memory_order_relaxed);
+		if (k >= s) return;
+		if (!fields[k]) {
+		    out[k] = na;
+		} else if (!parse(fields[k], &out[k])) {
+		    while (k < s && !stop.compare_exchange_weak(s, k)) {}
+		    return;
+		}
+	    }
+	});
+    return stop;
+}
+
 /* type.convert(char, na.strings, as.is, dec, numerals) */
 
 /* This is a horrible hack which is used in read.table to take a
@@ -649,9 +697,31 @@ SEXP typeconvert(SEXP call, SEXP op, SEXP args, SEXP env)
 	if (typeInfo.islogical) done = TRUE;
     }
 
+    /* The fields to be parsed by convert_fields(), with those that
+       are NA as null pointers. */
+    std::vector<const char *> fields;
+    if (!done && (typeInfo.isinteger || typeInfo.isreal)
+	&& len >= TYPECONVERT_PARALLEL_MIN
+	&& rho::ThreadPool::numThreads() > 1) {
+	fields.resize(len);
+	for (i = 0; i < len; i++) {
+	    tmp = CHAR(STRING_ELT(cvec, i));
+	    if (!(STRING_ELT(cvec, i) == NA_STRING || strlen(tmp) == 0
+		  || isNAstring(tmp, 1, &data) || isBlankString(tmp)))
+		fields[i] = tmp;
+	}
+    }
+
     if (!done && typeInfo.isinteger) {
 	rval = allocVector(INTSXP, len);
-	for (i = 0; i < len; i++) {
+	i = 0;
+	if (!fields.empty())
+	    i = (int) convert_fields(fields, INTEGER(rval), NA_INTEGER,
+				     [](const char *s, int *v) {
+					 *v = Strtoi(s, 10);
+					 return *v != NA_INTEGER;
+				     });
+	for (; i < len; i++) {
 	    tmp = CHAR(STRING_ELT(cvec, i));
 	    if (STRING_ELT(cvec, i) == NA_STRING || strlen(tmp) == 0
 		|| isNAstring(tmp, 1, &data) || isBlankString(tmp))
@@ -670,7 +740,19 @@ SEXP typeconvert(SEXP call, SEXP op, SEXP args, SEXP env)
 
     if (!done && typeInfo.isreal) {
 	rval = allocVector(REALSXP, len);
-	for (i = 0; i < len; i++) {
+	i = 0;
+	/* With numerals = "warn.loss" the parser may warn. */
+	if (!fields.empty() && i_exact != NA_INTEGER) {
+	    char decchar = data.decchar;
+	    i = (int) convert_fields(fields, REAL(rval), NA_REAL,
+				     [=](const char *s, double *v) {
+					 char *end;
+					 *v = R_strtod5(s, &end, decchar,
+							FALSE, i_exact);
+					 return isASCIIBlank(end);
+				     });
+	}
+	for (; i < len; i++) {
 	    tmp = CHAR(STRING_ELT(cvec, i));
 	    if (STRING_ELT(cvec, i) == NA_STRING || strlen(tmp) == 0
 		|| isNAstring(tmp, 1, &data) || isBlankString(tmp))
@@ -1018,13 +1100,42 @@ static const char
     return EncodeElement0(x, indx, quote ? '"' : 0, dec);
 }
 
+/* write.table() formats its output into a buffer, which is written
+   to the connection a block at a time rather than a field at a time.
+
+   When every column is logical, integer, double, character or an
+   integer-coded factor, rows are formatted by wt_format_rows() from a
+   wt_column description of each column.  The work that needs the R
+   heap, translating strings and encoding factor levels, is done while
+   the descriptions are made, so that long tables can be formatted a
+   block of rows at a time by the threads of rho::ThreadPool.  Other
+   tables are formatted element by element as before. */
+
+/* Most written to the connection at once: a piece this size passes
+   through dummy_vfprintf() without being formatted twice. */
+#define WT_PIECE_SIZE 8192
+/* Rows formatted as one task. */
+#define WT_BLOCK_ROWS 2048
+
 typedef struct wt_info {
     Rboolean wasopen;
     Rconnection con;
     R_StringBuffer *buf;
     int savedigits;
+    std::string *out;
 } wt_info;
 
+static void wt_flush(wt_info *wi, size_t keep)
+{
+    std::string &out = *wi->out;
+    if (out.size() <= keep) return;
+    for (size_t pos = 0; pos < out.size(); pos += WT_PIECE_SIZE) {
+	size_t n = std::min(out.size() - pos, (size_t) WT_PIECE_SIZE);
+	Rconn_printf(wi->con, "%.*s", (int) n, out.data() + pos);
+    }
+    out.clear();
+}
+
 /* utility to cleanup e.g. after interrpts */
 static void wt_cleanup(wt_info* ld)
 {
@@ -1033,6 +1144,178 @@ static void wt_cleanup(wt_info* ld)
     R_print.digits = ld->savedigits;
 }
 
+typedef enum { WT_LGL, WT_INT, WT_REAL, WT_STR, WT_FACTOR } wt_kind;
+
+typedef struct wt_column {
+    wt_kind kind;
+    Rboolean quote;
+    const int *ip;			/* WT_LGL, WT_INT, WT_FACTOR */
+    const double *rp;			/* WT_REAL */
+    std::vector<const char *> strs;	/* WT_STR: translated, NULL if NA */
+    std::vector<std::string> levels;	/* WT_FACTOR: as written */
+} wt_column;
+
+/* Appends s, quoted and with its quotes escaped if quote is true, as
+   EncodeElement2() would write it. */
+static void wt_append_string(std::string &out, const char *s,
+			     Rboolean quote, Rboolean qmethod)
+{
+    if (!quote) {
+	out += s;
+	return;
+    }
+    out += '"';
+    for (const char *q; (q = strchr(s, '"')); s = q + 1) {
+	out.append(s, q - s);
+	out += qmethod ? '\\' : '"';
+	out += '"';
+    }
+    out += s;
+    out += '"';
+}
+
+/* Describes the nr elements of x from offset, which are a column of
+   the table, or its row names if rownames is true.  Row names are
+   written as EncodeElement2() writes them, an NA as the string "NA"
+   rather than as the na argument.  Returns FALSE if the column has to
+   be formatted element by element. */
+static Rboolean wt_describe(wt_column *col, SEXP x, R_xlen_t offset,
+			    int nr, SEXP levels, Rboolean quote,
+			    Rboolean qmethod, R_StringBuffer *buff,
+			    const char *sdec, Rboolean rownames)
+{
+    col->quote = quote;
+    if (rownames && TYPEOF(x) != STRSXP) return FALSE;
+    if (!isNull(levels)) {
+	if (TYPEOF(x) != INTSXP) return FALSE;
+	int nlev = LENGTH(levels);
+	const int *codes = INTEGER(x) + offset;
+	for (int i = 0; i < nr; i++)
+	    if (codes[i] != NA_INTEGER && (codes[i] < 1 || codes[i] > nlev))
+		return FALSE;
+	col->kind = WT_FACTOR;
+	col->ip = codes;
+	col->levels.resize(nlev);
+	for (int k = 0; k < nlev; k++)
+	    col->levels[k] = EncodeElement2(levels, k, quote, qmethod,
+					    buff, sdec);
+	return TRUE;
+    }
+    switch (TYPEOF(x)) {
+    case LGLSXP:
+	col->kind = WT_LGL;
+	col->ip = LOGICAL(x) + offset;
+	return TRUE;
+    case INTSXP:
+	col->kind = WT_INT;
+	col->ip = INTEGER(x) + offset;
+	return TRUE;
+    case REALSXP:
+	col->kind = WT_REAL;
+	col->rp = REAL(x) + offset;
+	return TRUE;
+    case STRSXP:
+	col->kind = WT_STR;
+	col->strs.resize(nr);
+	for (int i = 0; i < nr; i++) {
+	    SEXP el = STRING_ELT(x, offset + i);
+	    col->strs[i] = (el == NA_STRING && !rownames)
+		? NULL : translateChar(el);
+	}
+	return TRUE;
+    default:
+	return FALSE;
+    }
+}
+
+/* Appends rows [begin, end) of the table.  Uses no R heap objects, so
+   can be run by a worker thread. */
+static void wt_format_rows(std::string &out,
+			   const std::vector<wt_column> &cols,
+			   int begin, int end, const char *csep,
+			   const char *ceol, const char *cna,
+			   Rboolean qmethod, char cdec)
+{
+    char buf[R_ENCODE_REAL_BUFSIZE];
+    for (int i = begin; i < end; i++) {
+	for (size_t j = 0; j < cols.size(); j++) {
+	    const wt_column &col = cols[j];
+	    if (j > 0) out += csep;
+	    switch (col.kind) {
+	    case WT_LGL:
+		if (col.ip[i] == NA_LOGICAL) out += cna;
+		else out += col.ip[i] ? "TRUE" : "FALSE";
+		break;
+	    case WT_INT:
+		if (col.ip[i] == NA_INTEGER) out += cna;
+		else {
+		    snprintf(buf, sizeof buf, "%d", col.ip[i]);
+		    out += buf;
+		}
+		break;
+	    case WT_REAL:
+		{
+		    double x = col.rp[i];
+		    if (ISNAN(x)) out += cna;
+		    else {
+			int w, d, e;
+			formatReal(&x, 1, &w, &d, &e, 0);
+			EncodeRealBuf(buf, x, w, d, e, cdec);
+			out += buf;
+		    }
+		}
+		break;
+	    case WT_STR:
+		if (!col.strs[i]) out += cna;
+		else wt_append_string(out, col.strs[i], col.quote, qmethod);
+		break;
+	    case WT_FACTOR:
+		if (col.ip[i] == NA_INTEGER) out += cna;
+		else out += col.levels[col.ip[i] - 1];
+		break;
+	    }
+	}
+	out += ceol;
+    }
+}
+
+/* Writes the table described by cols, using the threads of
+   rho::ThreadPool if it is long enough. */
+static void wt_write_rows(wt_info *wi, const std::vector<wt_column> &cols,
+			  int nr, const char *csep, const char *ceol,
+			  const char *cna, Rboolean qmethod, char cdec)
+{
+    size_t nthreads = rho::ThreadPool::numThreads();
+    if (nthreads <= 1 || nr < 2 * WT_BLOCK_ROWS) {
+	for (int i = 0; i < nr; i += WT_BLOCK_ROWS) {
+	    R_CheckUserInterrupt();
+	    wt_format_rows(*wi->out, cols, i, std::min(nr, i + WT_BLOCK_ROWS),
+			   csep, ceol, cna, qmethod, cdec);
+	    wt_flush(wi, WT_PIECE_SIZE);
+	}
+	return;
+    }
+    /* Blocks are formatted a batch at a time, and written in order. */
+    std::vector<std::string> blocks(4 * nthreads);
+    for (int b0 = 0; b0 < nr; b0 += (int) blocks.size() * WT_BLOCK_ROWS) {
+	R_CheckUserInterrupt();
+	size_t nblocks = std::min(blocks.size(),
+				  (size_t) (nr - b0 + WT_BLOCK_ROWS - 1)
+				  / WT_BLOCK_ROWS);
+	rho::ThreadPool::run(nblocks, [&](size_t k) {
+		int begin = b0 + (int) k * WT_BLOCK_ROWS;
+		blocks[k].clear();
+		wt_format_rows(blocks[k], cols, begin,
+			       std::min(nr, begin + WT_BLOCK_ROWS),
+			       csep, ceol, cna, qmethod, cdec);
+	    });
+	for (size_t k = 0; k < nblocks; k++) {
+	    wi->out->swap(blocks[k]);
+	    wt_flush(wi, 0);
+	}
+    }
+}
+
 extern "C"
 SEXP writetable(SEXP call, SEXP op, SEXP args, SEXP env)
 {
@@ -1043,6 +1326,7 @@ SEXP writetable(SEXP call, SEXP op, SEXP args, SEXP env)
     SEXP *levels;
     R_StringBuffer strBuf = {NULL, 0, MAXELTSIZE};
     wt_info wi;
+    std::string out;
 
     args = CDR(args);
 
@@ -1096,11 +1380,12 @@ SEXP writetable(SEXP call, SEXP op, SEXP args, SEXP env)
     wi.con = con;
     wi.wasopen = wasopen;
     wi.buf = &strBuf;
+    wi.out = &out;
     try {
-	if(isVectorList(x)) { /* A data frame */
-
+	Rboolean df = Rboolean(isVectorList(x));
+	levels = (SEXP *) R_alloc(nc, sizeof(SEXP));
+	if(df) { /* A data frame */
 	    /* handle factors internally, check integrity */
-	    levels = (SEXP *) R_alloc(nc, sizeof(SEXP));
 	    for(int j = 0; j < nc; j++) {
 		xj = VECTOR_ELT(x, j);
 		if(LENGTH(xj) != nr)
@@ -1109,17 +1394,55 @@ SEXP writetable(SEXP call, SEXP op, SEXP args, SEXP env)
 		    levels[j] = getAttrib(xj, R_LevelsSymbol);
 		} else levels[j] = R_NilValue;
 	    }
+	} else { /* A matrix */
+	    if(!isVectorAtomic(x))
+		UNIMPLEMENTED_TYPE("write.table, matrix method", x);
+	    /* quick integrity check */
+	    if(XLENGTH(x) != (R_len_t)nr * nc)
+		error(_("corrupt matrix -- dims not not match length"));
+	    for(int j = 0; j < nc; j++) levels[j] = R_NilValue;
+	}
 
+	/* Row names are written as a first column. */
+	std::vector<wt_column> cols(nc + !isNull(rnames));
+	Rboolean fast = Rboolean(nc > 0 || isNull(rnames));
+	size_t k = 0;
+	if(!isNull(rnames))
+	    fast = Rboolean(fast && wt_describe(&cols[k++], rnames, 0, nr,
+						R_NilValue, quote_rn,
+						Rboolean(qmethod), &strBuf,
+						sdec, TRUE));
+	for(int j = 0; fast && j < nc; j++) {
+	    if(df)
+		fast = wt_describe(&cols[k++], VECTOR_ELT(x, j), 0, nr,
+				   levels[j], quote_col[j], Rboolean(qmethod),
+				   &strBuf, sdec, FALSE);
+	    else
+		fast = wt_describe(&cols[k++], x, R_xlen_t(j) * nr, nr,
+				   R_NilValue, quote_col[j], Rboolean(qmethod),
+				   &strBuf, sdec, FALSE);
+	}
+
+	if(fast)
+	    wt_write_rows(&wi, cols, nr, csep, ceol, cna, Rboolean(qmethod),
+			  sdec[0]);
+	else {
+	    cols.clear();
 	    for(int i = 0; i < nr; i++) {
-		if(i % 1000 == 999) R_CheckUserInterrupt();
-		if(!isNull(rnames))
-		    Rconn_printf(con, "%s%s",
-				 EncodeElement2(rnames, i, quote_rn, Rboolean(qmethod),
-						&strBuf, sdec), csep);
+		if(i % 1000 == 999) {
+		    R_CheckUserInterrupt();
+		    wt_flush(&wi, WT_PIECE_SIZE);
+		}
+		if(!isNull(rnames)) {
+		    out += EncodeElement2(rnames, i, quote_rn, Rboolean(qmethod),
+					  &strBuf, sdec);
+		    out += csep;
+		}
 		for(int j = 0; j < nc; j++) {
-		    xj = VECTOR_ELT(x, j);
-		    if(j > 0) Rconn_printf(con, "%s", csep);
-		    if(isna(xj, i)) tmp = cna;
+		    xj = df ? VECTOR_ELT(x, j) : x;
+		    int ij = df ? i : i + j*nr;
+		    if(j > 0) out += csep;
+		    if(isna(xj, ij)) tmp = cna;
 		    else {
 			if(!isNull(levels[j])) {
 			    /* We do not assume factors have integer levels,
@@ -1137,43 +1460,17 @@ SEXP writetable(SEXP call, SEXP op, SEXP args, SEXP env)
 				error(_("column %s claims to be a factor but does not have numeric codes"),
 				      j+1);
 			} else {
-			    tmp = EncodeElement2(xj, i, quote_col[j], Rboolean(qmethod),
+			    tmp = EncodeElement2(xj, ij, quote_col[j],
+						 Rboolean(qmethod),
 						 &strBuf, sdec);
 			}
 		    }
-		    Rconn_printf(con, "%s", tmp);
-		}
-		Rconn_printf(con, "%s", ceol);
-	    }
-
-	} else { /* A matrix */
-
-	    if(!isVectorAtomic(x))
-		UNIMPLEMENTED_TYPE("write.table, matrix method", x);
-	    /* quick integrity check */
-	    if(XLENGTH(x) != (R_len_t)nr * nc)
-		error(_("corrupt matrix -- dims not not match length"));
-	    
-	    for(int i = 0; i < nr; i++) {
-		if(i % 1000 == 999) R_CheckUserInterrupt();
-		if(!isNull(rnames))
-		    Rconn_printf(con, "%s%s",
-				 EncodeElement2(rnames, i, quote_rn,
-						Rboolean(qmethod),
-						&strBuf, sdec), csep);
-		for(int j = 0; j < nc; j++) {
-		    if(j > 0) Rconn_printf(con, "%s", csep);
-		    if(isna(x, i + j*nr)) tmp = cna;
-		    else {
-			tmp = EncodeElement2(x, i + j*nr, quote_col[j],
-					     Rboolean(qmethod),
-					     &strBuf, sdec);
-		    }
-		    Rconn_printf(con, "%s", tmp);
+		    out += tmp;
 		}
-		Rconn_printf(con, "%s", ceol);
+		out += ceol;
 	    }
 	}
+	wt_flush(&wi, 0);
     } catch (...) {
 	wt_cleanup(&wi);
 	throw;
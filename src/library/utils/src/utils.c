@@ -42,6 +42,12 @@ SEXP Rprofmem(SEXP args)
     return do_Rprofmem(CDR(args));
 }
 
+SEXP do_Rprofalloc(SEXP args);
+SEXP Rprofalloc(SEXP args)
+{
+    return do_Rprofalloc(CDR(args));
+}
+
 /* from src/main/dounzip.c */
 SEXP Runzip(SEXP args);
 
@@ -0,0 +1,300 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/** @file AllocationProfiler.cpp
+ *
+ * @brief Implementation of class rho::AllocationProfiler.
+ */
+
+#include "rho/AllocationProfiler.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+#include "Defn.h"
+#include "pprof.h"
+#include "rho/Evaluator_Context.hpp"
+#include "rho/FunctionContext.hpp"
+#include "rho/GCNode.hpp"
+#include "rho/RObject.hpp"
+#include "rho/Symbol.hpp"
+
+using namespace rho;
+
+bool AllocationProfiler::s_running = false;
+std::ptrdiff_t AllocationProfiler::s_countdown
+    = std::numeric_limits<std::ptrdiff_t>::max();
+const GCNode* AllocationProfiler::s_pending_node = nullptr;
+
+namespace {
+    // What samples are aggregated by.  Strings are indices into
+    // the string table.
+    struct SampleKey {
+	std::vector<uint64_t> stack;  // Innermost function first.
+	uint64_t type;
+	uint64_t size_class;
+
+	bool operator<(const SampleKey& other) const
+	{
+	    if (type != other.type)
+		return type < other.type;
+	    if (size_class != other.size_class)
+		return size_class < other.size_class;
+	    return stack < other.stack;
+	}
+    };
+
+    // Estimated allocations represented by the samples.
+    struct Totals {
+	double objects = 0.0;
+	double bytes = 0.0;
+    };
+
+    struct Profile {
+	double interval = 0.0;
+	int64_t start_nanos = 0;
+	std::chrono::steady_clock::time_point start_time;
+	std::chrono::steady_clock::time_point stop_time;
+	std::mt19937_64 rng;
+	std::vector<std::string> strings;
+	std::unordered_map<std::string, uint64_t> string_index;
+	std::map<SampleKey, Totals> samples;
+
+	// The sample whose GCNode has yet to be examined.
+	SampleKey pending_key;
+	Totals pending_totals;
+
+	uint64_t intern(const std::string& str)
+	{
+	    auto it = string_index.find(str);
+	    if (it != string_index.end())
+		return it->second;
+	    uint64_t index = strings.size();
+	    strings.push_back(str);
+	    string_index[str] = index;
+	    return index;
+	}
+
+	void reset(double mean_gap)
+	{
+	    interval = mean_gap;
+	    // A fixed seed makes repeated runs give identical profiles.
+	    rng.seed(0x5eed);
+	    strings.clear();
+	    string_index.clear();
+	    samples.clear();
+	    intern("");
+	}
+    };
+
+    Profile* s_profile = nullptr;
+
+    // Bytes until the next sample.
+    std::ptrdiff_t nextGap()
+    {
+	std::exponential_distribution<double>
+	    gap(1.0/s_profile->interval);
+	double bytes = std::ceil(gap(s_profile->rng));
+	return std::ptrdiff_t(std::min(bytes, 1e15));
+    }
+
+    // Blocks of up to 256 bytes are classed to the next multiple of
+    // 8 bytes, larger ones to the next power of 2.
+    uint64_t sizeClass(std::size_t bytes)
+    {
+	if (bytes <= 256)
+	    return (bytes + 7) & ~std::size_t(7);
+	uint64_t size_class = 512;
+	while (size_class < bytes)
+	    size_class <<= 1;
+	return size_class;
+    }
+
+    // The current R call stack, as indices into the string table.
+    std::vector<uint64_t> callStack()
+    {
+	std::vector<uint64_t> stack;
+	for (Evaluator::Context* cptr = Evaluator::Context::innermost();
+	     cptr; cptr = cptr->nextOut()) {
+	    Evaluator::Context::Type type = cptr->type();
+	    if (type == Evaluator::Context::FUNCTION
+		|| type == Evaluator::Context::CLOSURE) {
+		FunctionContext* fctxt = static_cast<FunctionContext*>(cptr);
+		const RObject* fun = fctxt->call()->car();
+		stack.push_back(s_profile->intern(
+		    fun && fun->sexptype() == SYMSXP
+		    ? static_cast<const Symbol*>(fun)->name()->stdstring()
+		    : std::string("<Anonymous>")));
+	    }
+	}
+	if (stack.empty())
+	    stack.push_back(s_profile->intern("<TopLevel>"));
+	return stack;
+    }
+
+    std::string className(const GCNode* node)
+    {
+	const char* name = typeid(*node).name();
+#ifdef __GNUC__
+	int status;
+	char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+	if (demangled) {
+	    std::string result(demangled);
+	    std::free(demangled);
+	    return result;
+	}
+#endif
+	return name;
+    }
+
+    void record(const SampleKey& key, const Totals& totals)
+    {
+	Totals& sum = s_profile->samples[key];
+	sum.objects += totals.objects;
+	sum.bytes += totals.bytes;
+    }
+}
+
+void AllocationProfiler::start(double interval)
+{
+    if (!s_profile)
+	s_profile = new Profile;
+    s_pending_node = nullptr;
+    s_profile->reset(interval);
+    s_profile->start_nanos
+	= std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::system_clock::now().time_since_epoch()).count();
+    s_profile->start_time = std::chrono::steady_clock::now();
+    s_countdown = nextGap();
+    s_running = true;
+}
+
+void AllocationProfiler::stop()
+{
+    if (!s_running)
+	return;
+    resolvePending();
+    if (s_pending_node)
+	resolvePendingNode(true);
+    s_running = false;
+    s_countdown = std::numeric_limits<std::ptrdiff_t>::max();
+    s_profile->stop_time = std::chrono::steady_clock::now();
+}
+
+void AllocationProfiler::sample(std::size_t bytes, const GCNode* node)
+{
+    if (!s_running) {
+	s_countdown = std::numeric_limits<std::ptrdiff_t>::max();
+	return;
+    }
+    // A block may be big enough to span several sampling points;
+    // it is sampled once, and weighted accordingly.
+    s_countdown = nextGap();
+
+    // At most one node awaits examination.  By now it has almost
+    // certainly been constructed.
+    resolvePending();
+    if (s_pending_node)
+	resolvePendingNode(true);
+
+    SampleKey key;
+    key.stack = callStack();
+    key.size_class = sizeClass(bytes);
+    Totals totals;
+    double size = double(std::max(bytes, std::size_t(1)));
+    totals.objects = 1.0/(-std::expm1(-size/s_profile->interval));
+    totals.bytes = size*totals.objects;
+    if (node) {
+	s_profile->pending_key = std::move(key);
+	s_profile->pending_totals = totals;
+	s_pending_node = node;
+    } else {
+	key.type = s_profile->intern("(block)");
+	record(key, totals);
+    }
+}
+
+void AllocationProfiler::resolvePendingNode(bool freed)
+{
+    const GCNode* node = s_pending_node;
+    std::string type;
+    if (freed)
+	type = "GCNode";
+    else if (typeid(*node) == typeid(GCNode)) {
+	// GCNode::operator new has returned, but the object's
+	// constructor has not yet been entered.
+	return;
+    } else if (const RObject* obj = dynamic_cast<const RObject*>(node)) {
+	SEXP name = Rf_type2str_nowarn(obj->sexptype());
+	type = (name != R_NilValue ? CHAR(name) : "unknown");
+    } else
+	type = className(node);
+    s_pending_node = nullptr;
+    s_profile->pending_key.type = s_profile->intern(type);
+    record(s_profile->pending_key, s_profile->pending_totals);
+}
+
+bool AllocationProfiler::writeProfile(std::FILE* file)
+{
+    if (!s_profile)
+	return false;
+    if (s_running) {
+	resolvePending();
+	s_profile->stop_time = std::chrono::steady_clock::now();
+    }
+    // Interning the strings in order keeps their indices.
+    PprofProfile profile;
+    for (const std::string& str : s_profile->strings)
+	profile.intern(str);
+    profile.addSampleType("alloc_objects", "count");
+    profile.addSampleType("alloc_space", "bytes");
+    PprofProfile::Label type_label = {profile.intern("type"), 0, 0, 0};
+    PprofProfile::Label size_label = {profile.intern("size_class"), 0, 0,
+				      profile.intern("bytes")};
+    for (const auto& entry : s_profile->samples) {
+	const SampleKey& key = entry.first;
+	type_label.str = key.type;
+	size_label.num = key.size_class;
+	profile.addSample(key.stack, {std::llround(entry.second.objects),
+		    std::llround(entry.second.bytes)},
+	    {type_label, size_label});
+    }
+    profile.setPeriod("space", "bytes", int64_t(s_profile->interval));
+    profile.setTime(s_profile->start_nanos,
+		    std::chrono::duration_cast<std::chrono::nanoseconds>(
+			s_profile->stop_time - s_profile->start_time).count());
+    return profile.write(file);
+}
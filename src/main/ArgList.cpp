@@ -224,6 +224,18 @@ const Symbol* ArgList::tag2Symbol(const RObject* tag)
 
 void ArgList::wrapInPromises(Environment* env,
 			     const Expression* call)
+{
+    wrapInPromises(env, call, true);
+}
+
+void ArgList::wrapInPromisesForClosure(Environment* env,
+				       const Expression* call)
+{
+    wrapInPromises(env, call, false);
+}
+
+void ArgList::wrapInPromises(Environment* env,
+			     const Expression* call, bool wrap_constants)
 {
     if (m_status == PROMISED)
 	return;
@@ -249,6 +261,10 @@ void ArgList::wrapInPromises(Environment* env,
 	    value = Promise::createEvaluatedPromise(rawvalue, m_first_arg);
 	    m_first_arg = nullptr;
 	    m_first_arg_env = nullptr;
+	} else if (!wrap_constants && Promise::isConstant(rawvalue)) {
+	    // As RObject::evaluate() would:
+	    SET_NAMED(rawvalue, 2);
+	    value = rawvalue;
 	} else if (rawvalue != Symbol::missingArgument())
 	    value = new Promise(rawvalue, env);
 	lastout = append(value, tag, lastout);
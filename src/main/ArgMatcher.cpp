@@ -113,7 +113,11 @@ void ArgMatcher::makeBinding(Environment* target_env, const FormalData& fdata,
 			     RObject* value)
 {
     if (origin == Frame::Binding::DEFAULTED) {
-	if (fdata.value != Symbol::missingArgument())
+	if (Promise::isConstant(fdata.value)) {
+	    // As RObject::evaluate() would:
+	    SET_NAMED(fdata.value, 2);
+	    value = fdata.value;
+	} else if (fdata.value != Symbol::missingArgument())
 	    value = new Promise(fdata.value, target_env);
     }
     Frame::Binding* bdg = target_env->frame()->obtainBinding(fdata.symbol);
@@ -165,6 +169,7 @@ struct ArgMatchInfo::Hash {
 	size_t seed = 0;
 	boost::hash_combine(seed, item->m_num_formals);
 	boost::hash_combine(seed, item->m_values);
+	boost::hash_combine(seed, item->m_tags);
 	return seed;
     }
 };
@@ -289,7 +294,7 @@ bool ArgMatchInfo::arglistTagsMatch(const PairList* args) const {
     size_t index;
     for (index = 0; index < m_tags.size() && arg != nullptr;
 	 ++index, arg = arg->tail()) {
-	if (m_tags[index] != args->tag())
+	if (m_tags[index] != arg->tag())
 	    return false;
     }
     if (index != m_tags.size() || arg != nullptr) {
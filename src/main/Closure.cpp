@@ -90,6 +90,7 @@ void Closure::detachReferents()
     m_matcher.detach();
     m_body.detach();
     m_environment.detach();
+    m_spare_env.detach();
     m_compiled_body.detach();
     FunctionBase::detachReferents();
 }
@@ -105,7 +106,7 @@ RObject* Closure::execute(Environment* env) const
 #ifdef ENABLE_LLVM_JIT
 	if (m_compiled_body
 	    && m_compiled_body->hasMatchingFrameLayout(env)) {
-	    PlainContext boctxt;
+	    CompiledCodeContext boctxt;
 	    ans = m_compiled_body->evalInEnvironment(env);
 	} else {
 	    if (!m_compiled_body && m_num_invokes == 100) {
@@ -147,12 +148,17 @@ void Closure::compile() const {
 }
 
 Environment* Closure::createExecutionEnv() const {
-    Frame* frame =
 #ifdef ENABLE_LLVM_JIT
-        m_compiled_body ? m_compiled_body->createFrame():
+    if (m_compiled_body)
+	return new Environment(environment(), m_compiled_body->createFrame());
 #endif
-        new ListFrame;
-    return new Environment(environment(), frame);
+    if (m_spare_env) {
+	Environment* env = m_spare_env;
+	m_spare_env = nullptr;
+	env->setEnclosingEnvironment(environment());
+	return env;
+    }
+    return new Environment(environment(), new ListFrame);
 }
 
 const char* Closure::typeName() const
@@ -185,6 +191,7 @@ void Closure::visitReferents(const_visitor* v) const
     const ArgMatcher* matcher = m_matcher;
     const GCNode* body = m_body;
     const GCNode* environment = m_environment;
+    const GCNode* spare_env = m_spare_env;
     const GCNode* compiled_body = m_compiled_body;
 
     FunctionBase::visitReferents(v);
@@ -194,6 +201,8 @@ void Closure::visitReferents(const_visitor* v) const
 	(*v)(body);
     if (environment)
 	(*v)(environment);
+    if (spare_env)
+	(*v)(spare_env);
     if (compiled_body)
 	(*v)(compiled_body);
 }
@@ -116,6 +116,21 @@ void Environment::detachReferents()
     RObject::detachReferents();
 }
 
+bool Environment::clearForReuse(const RObject* result)
+{
+    Frame* frame = m_frame;
+    if (result == this || m_leaked || m_locked || m_on_search_path
+	|| m_single_stepping || referenceCount() != 0 || attributes()
+	|| !frame || frame->referenceCount() != 1 || frame->isLocked()
+	|| frame->m_read_monitored || frame->m_write_monitored
+	|| typeid(*frame) != typeid(ListFrame))
+	return false;
+    frame->clear();
+    m_in_loop = false;
+    m_can_return = false;
+    return true;
+}
+
 // Define the preprocessor variable CHECK_CACHE to verify that the
 // search list cache is delivering correct results.
 
@@ -124,17 +139,20 @@ Frame::Binding* Environment::findBinding(const Symbol* symbol)
     bool cache_miss = false;
     Environment* env = this;
 #ifdef CHECK_CACHE
+    bool cache_hit = false;
     Frame::Binding* cache_binding = 0;
 #endif
     Cache* search_path_cache = searchPathCache();
     while (env) {
 	if (env->isSearchPathCachePortal()) {
-	    // TODO: the cache isn't effective for S3 methods.
 	    Cache::iterator it = search_path_cache->find(symbol);
 	    if (it == search_path_cache->end())
 		cache_miss = true;
 #ifdef CHECK_CACHE
-	    else cache_binding = it->second;
+	    else {
+		cache_hit = true;
+		cache_binding = it->second;
+	    }
 #else
 	    else return it->second;
 #endif
@@ -142,7 +160,7 @@ Frame::Binding* Environment::findBinding(const Symbol* symbol)
 	Frame::Binding* bdg = env->frame()->binding(symbol);
 	if (bdg) {
 #ifdef CHECK_CACHE
-	    if (cache_binding && cache_binding != bdg)
+	    if (cache_hit && cache_binding != bdg)
 		abort();
 #endif
 	    if (cache_miss)
@@ -151,6 +169,15 @@ Frame::Binding* Environment::findBinding(const Symbol* symbol)
 	}
 	env = env->enclosingEnvironment();
     }
+    // Record that the symbol is unbound along the search path.  S3
+    // dispatch looks up many such symbols, e.g. print.foo for each
+    // class that has no print method.
+#ifdef CHECK_CACHE
+    if (cache_binding)
+	abort();
+#endif
+    if (cache_miss)
+	(*search_path_cache)[symbol] = nullptr;
     return nullptr;
 }
 
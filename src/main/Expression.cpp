@@ -298,7 +298,7 @@ RObject* Expression::invokeClosureImpl(const Closure* func,
     // We can't modify *parglist, as it's on the other side of a
     // GCStackFrameboundary, so make a copy instead.
     ArgList arglist(parglist->list(), parglist->status());
-    arglist.wrapInPromises(calling_env, this);
+    arglist.wrapInPromisesForClosure(calling_env, this);
 
     Environment* execution_env = func->createExecutionEnv();
     matchArgsIntoEnvironment(func, calling_env, &arglist, execution_env);
@@ -319,7 +319,8 @@ RObject* Expression::invokeClosureImpl(const Closure* func,
     }
 
     Environment::monitorLeaks(result);
-    execution_env->maybeDetachFrame();
+    if (!func->recycleExecutionEnv(execution_env, result))
+	execution_env->maybeDetachFrame();
 
     return result;
 }
@@ -354,15 +355,19 @@ CachingExpression* CachingExpression::clone() const
 
 void CachingExpression::visitReferents(const_visitor* v) const
 {
-    const GCNode* function = m_cache.m_function.get();
     Expression::visitReferents(v);
-    if (function)
-	(*v)(function);
+    if (m_cache) {
+	for (unsigned int i = 0; i < m_cache->m_num_entries; ++i) {
+	    const GCNode* function = m_cache->m_entries[i].m_function.get();
+	    if (function)
+		(*v)(function);
+	}
+    }
 }
 
 void CachingExpression::detachReferents()
 {
-    m_cache.m_function = nullptr;
+    m_cache.reset();
     Expression::detachReferents();
 }
 
@@ -372,28 +377,37 @@ void CachingExpression::matchArgsIntoEnvironment(const Closure* func,
                                           Environment* execution_env) const
 {
     const ArgMatcher* matcher = func->matcher();
+    const PairList* args = arglist->list();
+
+    if (m_cache) {
+	for (unsigned int i = 0; i < m_cache->m_num_entries; ++i) {
+	    const Cache::Entry& entry = m_cache->m_entries[i];
+	    if (entry.m_function == func
+		&& entry.m_arg_match_info->arglistTagsMatch(args)) {
+		matcher->match(execution_env, arglist, entry.m_arg_match_info);
+		return;
+	    }
+	}
+    }
 
-    if (!m_cache.m_function) {
+    // The context is needed for any error reported by the matching.
+    ClosureContext context(this, calling_env, func, func->environment(),
+			   args);
+    if (!m_cache)
+	m_cache.reset(new Cache);
+    if (m_cache->m_num_entries < Cache::NUM_ENTRIES) {
 	// TODO: Don't cache the matching the first time that the function is
 	// called.  This eliminates additional work and storage for
 	// functions that are only called once.
-	ArgList args(getArgs(), ArgList::RAW);
-	m_cache.m_arg_match_info = matcher->createMatchInfo(&args);
-	m_cache.m_function = func;
+	const ArgMatchInfo* matching = matcher->createMatchInfo(arglist);
+	if (matching) {
+	    Cache::Entry& entry = m_cache->m_entries[m_cache->m_num_entries++];
+	    entry.m_function = func;
+	    entry.m_arg_match_info = matching;
+	    matcher->match(execution_env, arglist, matching);
+	    return;
+	}
     }
-
-    if (m_cache.m_function == func
-	&& m_cache.m_arg_match_info
-	&& m_cache.m_arg_match_info->arglistTagsMatch(arglist->list()))
-    {
-	matcher->match(execution_env, arglist, m_cache.m_arg_match_info);
-	return;
-    }
-
-    // We weren't able to cache a matching, probably because getArgs()
-    // contains '...'.  Run the full matching algorithm instead.
-    ClosureContext context(this, calling_env, func, func->environment(),
-			   arglist->list());
     matcher->match(execution_env, arglist);
 }
 
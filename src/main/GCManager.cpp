@@ -37,6 +37,7 @@
 #include <limits>
 #include "Defn.h"
 #include "R_ext/Print.h"
+#include "rho/AllocationProfiler.hpp"
 #include "rho/GCNode.hpp"
 #include "rho/WeakRef.hpp"
 
@@ -91,6 +92,9 @@ void GCManager::gc(bool force_full_collection)
     s_gc_is_running = true;
     ++gc_count;
 
+    // Find the type of any sampled allocation before it can be freed:
+    AllocationProfiler::resolvePending();
+
     s_max_bytes = std::max(s_max_bytes, MemoryBank::bytesAllocated());
     s_max_nodes = std::max(s_max_nodes, GCNode::numNodes());
 
@@ -39,6 +39,7 @@
 #include <set>
 #include <utility>
 
+#include "rho/AllocationProfiler.hpp"
 #include "rho/GCManager.hpp"
 #include "rho/GCRoot.hpp"
 #include "rho/GCStackFrameBoundary.hpp"
@@ -71,7 +72,6 @@ unsigned char GCNode::s_mark = 0;
 
 HOT_FUNCTION void* GCNode::operator new(size_t bytes) {
     GCManager::maybeGC();
-    MemoryBank::notifyAllocation(bytes);
     void *result;
 
     result = GCNodeAllocator::allocate(bytes);
@@ -84,6 +84,7 @@ HOT_FUNCTION void* GCNode::operator new(size_t bytes) {
     // GC uses the reference counts, so this is always effective).
     // It will be overwritten by the real constructor.
     new (result)GCNode(static_cast<CreateAMinimallyInitializedGCNode*>(nullptr));
+    MemoryBank::notifyAllocation(bytes, static_cast<GCNode*>(result));
     return result;
 }
 
@@ -92,6 +93,7 @@ GCNode::GCNode(CreateAMinimallyInitializedGCNode*)
 }
 
 void GCNode::operator delete(void* pointer, size_t bytes) {
+    AllocationProfiler::notifyDeallocation(pointer);
     MemoryBank::notifyDeallocation(bytes);
 
     GCNodeAllocator::free(pointer);
@@ -29,6 +29,8 @@
 
 #include "rho/IntVector.hpp"
 
+#include "rho/GCRoot.hpp"
+#include "rho/ListVector.hpp"
 #include "rho/LogicalVector.hpp"
 
 using namespace rho;
@@ -44,4 +46,20 @@ namespace rho {
     const char* IntVector::staticTypeName() {
 	return "integer";
     }
+
+    IntVector* SmallIntVectors::s_table[SmallIntVectors::s_max
+					  - SmallIntVectors::s_min + 1];
+
+    void SmallIntVectors::initialize()
+    {
+	const int n = s_max - s_min + 1;
+	static GCRoot<ListVector> holder(ListVector::create(n));
+	for (int i = 0; i < n; ++i) {
+	    IntVector* scalar = IntVector::create(1);
+	    (*scalar)[0] = s_min + i;
+	    (*holder)[i] = scalar;
+	    MARK_NOT_MUTABLE(scalar);
+	    s_table[i] = scalar;
+	}
+    }
 }
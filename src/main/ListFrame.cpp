@@ -30,6 +30,8 @@
 
 #include "rho/ListFrame.hpp"
 
+#include <algorithm>
+
 #include "localization.h"
 #include "R_ext/Error.h"
 #include "rho/GCStackRoot.hpp"
@@ -39,18 +41,141 @@
 using namespace std;
 using namespace rho;
 
+// Open-addressing hash table from Symbols to the slots assigned to
+// them.  Collisions are resolved by linear probing with Robin Hood
+// insertion: an entry displaces any entry it meets that lies nearer
+// to its home bucket.  This bounds the variance of probe lengths, so
+// that lookups, including those of Symbols not in the table, stop
+// early.  Entries are removed by shifting their successors back.
+class ListFrame::Index {
+public:
+    explicit Index(size_t min_size)
+	: m_log_capacity(3), m_size(0)
+    {
+	while (capacity() < min_size + min_size/3)
+	    ++m_log_capacity;
+	m_entries.resize(capacity());
+    }
+
+    Binding* find(const Symbol* symbol) const
+    {
+	size_t mask = capacity() - 1;
+	size_t pos = home(symbol);
+	for (size_t dist = 0; ; ++dist, pos = (pos + 1) & mask) {
+	    const Entry& entry = m_entries[pos];
+	    if (entry.symbol == symbol)
+		return entry.binding;
+	    // Had the symbol been present, it would have displaced
+	    // an entry this near its home.
+	    if (!entry.symbol || distance(entry, pos) < dist)
+		return nullptr;
+	}
+    }
+
+    void insert(const Symbol* symbol, Binding* binding)
+    {
+	if (4*(m_size + 1) > 3*capacity())
+	    grow();
+	place(Entry{symbol, binding});
+	++m_size;
+    }
+
+    void erase(const Symbol* symbol)
+    {
+	size_t mask = capacity() - 1;
+	size_t pos = home(symbol);
+	while (m_entries[pos].symbol != symbol) {
+	    if (!m_entries[pos].symbol)
+		return;
+	    pos = (pos + 1) & mask;
+	}
+	size_t next = (pos + 1) & mask;
+	while (m_entries[next].symbol && distance(m_entries[next], next) > 0) {
+	    m_entries[pos] = m_entries[next];
+	    pos = next;
+	    next = (next + 1) & mask;
+	}
+	m_entries[pos] = Entry();
+	--m_size;
+    }
+private:
+    struct Entry {
+	const Symbol* symbol;
+	Binding* binding;
+
+	Entry(const Symbol* sym = nullptr, Binding* bdg = nullptr)
+	    : symbol(sym), binding(bdg)
+	{}
+    };
+
+    std::vector<Entry> m_entries;
+    unsigned int m_log_capacity;
+    size_t m_size;
+
+    size_t capacity() const
+    {
+	return size_t(1) << m_log_capacity;
+    }
+
+    // Fibonacci hashing.  Symbols are at least 16-byte aligned, so
+    // the low bits of their addresses carry no information.
+    size_t home(const Symbol* symbol) const
+    {
+	uint64_t key = reinterpret_cast<uintptr_t>(symbol) >> 4;
+	return size_t((key*UINT64_C(0x9e3779b97f4a7c15))
+		      >> (64 - m_log_capacity));
+    }
+
+    size_t distance(const Entry& entry, size_t pos) const
+    {
+	return (pos - home(entry.symbol)) & (capacity() - 1);
+    }
+
+    void place(Entry entry)
+    {
+	size_t mask = capacity() - 1;
+	size_t pos = home(entry.symbol);
+	for (size_t dist = 0; ; ++dist, pos = (pos + 1) & mask) {
+	    Entry& slot = m_entries[pos];
+	    if (!slot.symbol) {
+		slot = entry;
+		return;
+	    }
+	    size_t slot_dist = distance(slot, pos);
+	    if (slot_dist < dist) {
+		std::swap(slot, entry);
+		dist = slot_dist;
+	    }
+	}
+    }
+
+    void grow()
+    {
+	std::vector<Entry> old;
+	old.swap(m_entries);
+	++m_log_capacity;
+	m_entries.resize(capacity());
+	for (const Entry& entry : old)
+	    if (entry.symbol)
+		place(entry);
+    }
+};
+
 ListFrame::ListFrame(size_t size, bool check_list_size)
+    : m_used_bindings_size(0), m_overflow_used(0), m_index(nullptr),
+      m_num_assigned(0), m_heap_bindings(nullptr), m_heap_symbols(nullptr)
 {
-    m_used_bindings_size = 0;
-    m_overflow = nullptr;
-
-    if (check_list_size && size > kMaxListSize) {
-	size_t overflow_size = size - kMaxListSize;
-	m_overflow = new map(overflow_size);
+    if (check_list_size && size > kMaxListSize)
 	size = kMaxListSize;
+    size = std::max(size, kDefaultListSize);
+    std::fill(m_inline_symbols, m_inline_symbols + kDefaultListSize,
+	      nullptr);
+    if (size > kDefaultListSize) {
+	size_t heap_size = size - kDefaultListSize;
+	m_heap_bindings = new Binding[heap_size];
+	m_heap_symbols = new const Symbol*[heap_size];
+	std::fill(m_heap_symbols, m_heap_symbols + heap_size, nullptr);
     }
-
-    m_bindings = new Binding[size];
     m_bindings_size = size;
 }
 
@@ -64,27 +189,66 @@ ListFrame::ListFrame(const ListFrame &pattern)
 
 ListFrame::~ListFrame()
 {
-    delete[] m_bindings;
-    if (m_overflow) {
-	delete m_overflow;
+    delete[] m_heap_bindings;
+    delete[] m_heap_symbols;
+    for (OverflowSlot* block : m_overflow)
+	delete[] block;
+    delete m_index;
+}
+
+// The position of symbol among the first n of symbols, or n.
+static size_t scanSymbols(const Symbol* const* symbols, size_t n,
+			  const Symbol* symbol)
+{
+    // Four symbols are compared at a time, without branches, which
+    // the compiler can turn into vector instructions.
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+	bool hit = (symbols[i] == symbol) | (symbols[i + 1] == symbol)
+	    | (symbols[i + 2] == symbol) | (symbols[i + 3] == symbol);
+	if (hit)
+	    break;
+    }
+    for (; i < n; ++i) {
+	if (symbols[i] == symbol)
+	    return i;
     }
+    return n;
 }
 
-Frame::Binding* ListFrame::v_binding(const Symbol* symbol)
+Frame::Binding* ListFrame::findSlot(const Symbol* symbol)
 {
-    for (size_t i = 0; i < m_used_bindings_size; i++) {
-	if (m_bindings[i].symbol() == symbol && isSet(m_bindings[i]))
-	    return &m_bindings[i];
+    if (m_index)
+	return m_index->find(symbol);
+    size_t n = std::min(m_used_bindings_size, kDefaultListSize);
+    size_t i = scanSymbols(m_inline_symbols, n, symbol);
+    if (i < n)
+	return &m_inline_bindings[i];
+    if (m_used_bindings_size > kDefaultListSize) {
+	n = m_used_bindings_size - kDefaultListSize;
+	i = scanSymbols(m_heap_symbols, n, symbol);
+	if (i < n)
+	    return &m_heap_bindings[i];
     }
-    if (m_overflow) {
-	auto location = m_overflow->find(symbol);
-	if (location != m_overflow->end()) {
-	    return &location->second;
-	}
+    // Without an index, the overflow blocks hold only a few slots.
+    for (size_t b = 0; b < m_overflow.size(); ++b) {
+	size_t block_size = m_bindings_size << b;
+	size_t used = (b + 1 == m_overflow.size() ? m_overflow_used
+		       : block_size);
+	OverflowSlot* block = m_overflow[b];
+	for (size_t j = 0; j < used; ++j)
+	    if (block[j].symbol == symbol)
+		return &block[j].binding;
     }
     return nullptr;
 }
 
+Frame::Binding* ListFrame::v_binding(const Symbol* symbol)
+{
+    Binding* binding = findSlot(symbol);
+    return (binding && isSet(*binding)) ? binding : nullptr;
+}
+
 const Frame::Binding* ListFrame::v_binding(const Symbol* symbol) const
 {
     return const_cast<ListFrame*>(this)->v_binding(symbol);
@@ -92,14 +256,19 @@ const Frame::Binding* ListFrame::v_binding(const Symbol* symbol) const
 
 void ListFrame::visitBindings(std::function<void(const Binding*)> f) const
 {
+    ListFrame* self = const_cast<ListFrame*>(this);
     for (size_t i = 0; i < m_used_bindings_size; i++) {
-	if (isSet(m_bindings[i]))
-	    f(&m_bindings[i]);
+	const Binding* binding = self->slotBinding(i);
+	if (isSet(*binding))
+	    f(binding);
     }
-    if (m_overflow) {
-	for (const auto& entry : *m_overflow) {
-	    f(&entry.second);
-	}
+    for (size_t b = 0; b < m_overflow.size(); ++b) {
+	size_t used = (b + 1 == m_overflow.size() ? m_overflow_used
+		       : m_bindings_size << b);
+	const OverflowSlot* block = m_overflow[b];
+	for (size_t j = 0; j < used; ++j)
+	    if (isSet(block[j].binding))
+		f(&block[j].binding);
     }
 }
 
@@ -110,79 +279,147 @@ ListFrame* ListFrame::clone() const
 
 void ListFrame::lockBindings()
 {
-    for (size_t i = 0; i < m_used_bindings_size; i++) {
-	m_bindings[i].setLocking(true);
-    }
-    if (m_overflow) {
-	for (auto& item : *m_overflow) {
-	    item.second.setLocking(true);
-	}
-    }
+    visitBindings([](const Binding* binding) {
+	    const_cast<Binding*>(binding)->setLocking(true);
+	});
 }
 
 std::size_t ListFrame::size() const
 {
-  std::size_t result = 0;
-  for (int i = 0; i < m_used_bindings_size; ++i) {
-    if (isSet(m_bindings[i])) {
-      result++;
-    }
-  }
-  if (m_overflow) {
-    result += m_overflow->size();
-  }
-  return result;
+    std::size_t result = 0;
+    visitBindings([&](const Binding*) { ++result; });
+    return result;
 }
 
 void ListFrame::v_clear()
 {
     for (size_t i = 0; i < m_used_bindings_size; i++) {
-	unsetBinding(m_bindings + i);
+	unsetBinding(slotBinding(i));
+	slotSymbol(i) = nullptr;
     }
-    if (m_overflow) {
-	delete m_overflow;
-	m_overflow = nullptr;
+    m_used_bindings_size = 0;
+    for (OverflowSlot* block : m_overflow)
+	delete[] block;
+    m_overflow.clear();
+    m_overflow_free.clear();
+    m_overflow_used = 0;
+    delete m_index;
+    m_index = nullptr;
+    m_num_assigned = 0;
+}
+
+void ListFrame::freeSlot(Binding* binding)
+{
+    unsetBinding(binding);
+    const Symbol** symbol = nullptr;
+    if (binding >= m_inline_bindings
+	&& binding < m_inline_bindings + kDefaultListSize)
+	symbol = &m_inline_symbols[binding - m_inline_bindings];
+    else if (m_heap_bindings && binding >= m_heap_bindings
+	     && binding < (m_heap_bindings + m_bindings_size
+			   - kDefaultListSize))
+	symbol = &m_heap_symbols[binding - m_heap_bindings];
+    if (symbol) {
+	*symbol = nullptr;
+	while (m_used_bindings_size > 0
+	       && !slotSymbol(m_used_bindings_size - 1))
+	    --m_used_bindings_size;
+    } else {
+	OverflowSlot* slot = reinterpret_cast<OverflowSlot*>(
+	    reinterpret_cast<char*>(binding) - offsetof(OverflowSlot, binding));
+	slot->symbol = nullptr;
+	m_overflow_free.push_back(slot);
     }
+    --m_num_assigned;
 }
 
 bool ListFrame::v_erase(const Symbol* symbol)
 {
-    for (size_t i = 0; i < m_used_bindings_size; i++) {
-	if (m_bindings[i].symbol() == symbol && isSet(m_bindings[i]))
-	{
-	    unsetBinding(&m_bindings[i]);
-	    return true;
+    Binding* binding = findSlot(symbol);
+    if (!binding)
+	return false;
+    // The slot may have been assigned to the symbol by a call of
+    // obtainBinding() that then failed.
+    bool was_set = isSet(*binding);
+    if (m_index)
+	m_index->erase(symbol);
+    freeSlot(binding);
+    return was_set;
+}
+
+Frame::Binding* ListFrame::assignSlot(size_t index, const Symbol* symbol)
+{
+    slotSymbol(index) = symbol;
+    m_used_bindings_size = std::max(m_used_bindings_size, index + 1);
+    ++m_num_assigned;
+    if (m_index)
+	m_index->insert(symbol, slotBinding(index));
+    else if (m_num_assigned > kIndexThreshold)
+	buildIndex();
+    return slotBinding(index);
+}
+
+Frame::Binding* ListFrame::assignOverflowSlot(const Symbol* symbol)
+{
+    OverflowSlot* slot;
+    if (!m_overflow_free.empty()) {
+	slot = m_overflow_free.back();
+	m_overflow_free.pop_back();
+    } else {
+	size_t block_size = (m_overflow.empty() ? 0
+			     : m_bindings_size << (m_overflow.size() - 1));
+	if (m_overflow_used == block_size) {
+	    m_overflow.push_back(
+		new OverflowSlot[m_bindings_size << m_overflow.size()]);
+	    m_overflow_used = 0;
 	}
+	slot = &m_overflow.back()[m_overflow_used++];
     }
+    slot->symbol = symbol;
+    ++m_num_assigned;
+    if (m_index)
+	m_index->insert(symbol, &slot->binding);
+    else if (m_num_assigned > kIndexThreshold)
+	buildIndex();
+    return &slot->binding;
+}
 
-    if (m_overflow) {
-	return m_overflow->erase(symbol);
+void ListFrame::buildIndex()
+{
+    m_index = new Index(2*m_num_assigned);
+    for (size_t i = 0; i < m_used_bindings_size; ++i)
+	if (slotSymbol(i))
+	    m_index->insert(slotSymbol(i), slotBinding(i));
+    for (size_t b = 0; b < m_overflow.size(); ++b) {
+	size_t used = (b + 1 == m_overflow.size() ? m_overflow_used
+		       : m_bindings_size << b);
+	OverflowSlot* block = m_overflow[b];
+	for (size_t j = 0; j < used; ++j)
+	    if (block[j].symbol)
+		m_index->insert(block[j].symbol, &block[j].binding);
     }
-    return false;
 }
 
 Frame::Binding* ListFrame::v_obtainBinding(const Symbol* symbol)
 {
-    // If the binding exists, return that.
-    Frame::Binding* binding = v_binding(symbol);
+    // If a slot has been assigned to the symbol, return that.
+    Frame::Binding* binding = findSlot(symbol);
     if (binding) {
 	return binding;
     }
 
-    // Otherwise return the first unused space in the array if any.
-    for (size_t i = 0; i < m_bindings_size; ++i) {
-	if (!isSet(m_bindings[i])) {
-	    // Found an unused spot.
-	    m_used_bindings_size = std::max(m_used_bindings_size, i + 1);
-	    return &m_bindings[i];
+    // Otherwise use the first free slot in the array if any.
+    if (m_used_bindings_size < m_bindings_size)
+	return assignSlot(m_used_bindings_size, symbol);
+    if (m_num_assigned < m_bindings_size) {
+	for (size_t i = 0; i < m_bindings_size; ++i) {
+	    if (!slotSymbol(i))
+		return assignSlot(i, symbol);
 	}
     }
 
     // Otherwise go to the overflow.
-    if (!m_overflow) {
-	m_overflow = new map;
-    }
-    return &((*m_overflow)[symbol]);
+    return assignOverflowSlot(symbol);
 }
 
 void ListFrame::unsetBinding(Binding* binding)
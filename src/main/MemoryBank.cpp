@@ -29,6 +29,8 @@
 
 #include "rho/MemoryBank.hpp"
 
+#include "rho/AllocationProfiler.hpp"
+
 #include <iostream>
 #include <limits>
 #include <iterator>
@@ -103,7 +105,6 @@ void MemoryBank::adjustFreedSize(size_t original, size_t actual)
 
 void* MemoryBank::allocate(size_t bytes) throw (std::bad_alloc)
 {
-    notifyAllocation(bytes);
     void* p;
     if (bytes >= s_new_threshold)
 	p = ::operator new(bytes);
@@ -111,6 +112,7 @@ void* MemoryBank::allocate(size_t bytes) throw (std::bad_alloc)
 	Pool& pool = s_pools[s_pooltab[(bytes + 7) >> 3]];
 	p = pool.allocate();
     }
+    notifyAllocation(bytes);
     return p;
 }
 
@@ -148,8 +150,9 @@ void MemoryBank::initialize()
     s_pools[9].initialize(24, 21);
 }
 
-void MemoryBank::notifyAllocation(size_t bytes)
+void MemoryBank::notifyAllocation(size_t bytes, const GCNode* node)
 {
+    AllocationProfiler::notifyAllocation(bytes, node);
 #ifdef R_MEMORY_PROFILING
     if (s_monitor && bytes >= s_monitor_threshold) s_monitor(bytes);
 #endif
@@ -322,8 +322,7 @@ public:
 protected:
     virtual ~PaddedPairList() {}
 
-    void* m_unused_padding_1;
-    void* m_unused_padding_2;
+    void* m_unused_padding;
 };
 
 }  // anonymous namespace
@@ -0,0 +1,239 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/** @file ReadAhead.cpp
+ *
+ * @brief Implementation of class rho::ReadAhead.
+ */
+
+#include "rho/ReadAhead.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+using namespace rho;
+
+namespace {
+    // Every ReadAhead with a background thread in this process.
+    std::mutex s_registry_mutex;
+    std::set<ReadAhead*> s_registry;
+    std::once_flag s_atfork_once;
+}
+
+void ReadAhead::prepareFork()
+{
+    s_registry_mutex.lock();
+    for (ReadAhead* ahead : s_registry) {
+	std::unique_lock<std::mutex> lock(ahead->m_mutex);
+	ahead->m_filled.wait(lock, [ahead]{ return !ahead->m_reading; });
+	lock.release();
+    }
+}
+
+void ReadAhead::parentAfterFork()
+{
+    for (ReadAhead* ahead : s_registry) {
+	ahead->m_stopping = true;
+	ahead->m_mutex.unlock();
+	ahead->m_drained.notify_all();
+	ahead->m_thread->join();
+	delete ahead->m_thread;
+	ahead->m_thread = nullptr;
+    }
+    s_registry.clear();
+    s_registry_mutex.unlock();
+}
+
+void ReadAhead::childAfterFork()
+{
+    for (ReadAhead* ahead : s_registry) {
+	ahead->m_mutex.unlock();
+	// The thread does not exist here, and the std::thread object
+	// cannot be destroyed while it appears joinable.
+	ahead->m_thread = nullptr;
+    }
+    s_registry.clear();
+    s_registry_mutex.unlock();
+}
+
+ReadAhead::ReadAhead(Source source, std::size_t block_size,
+		     std::size_t nblocks)
+    : m_source(std::move(source)), m_block_size(block_size),
+      m_max_blocks(std::max(nblocks, std::size_t(1))), m_eof(false),
+      m_failed(false), m_stopping(false), m_reading(false), m_pos(0),
+      m_at_end(false), m_consumed(0), m_thread(nullptr)
+{
+#ifndef _WIN32
+    std::call_once(s_atfork_once, []{
+	    pthread_atfork(prepareFork, parentAfterFork, childAfterFork);
+	});
+#endif
+    // As for ThreadPool's workers, signals are left to the main thread.
+#ifndef _WIN32
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+#endif
+    try {
+	std::lock_guard<std::mutex> lock(s_registry_mutex);
+	s_registry.insert(this);
+	try {
+	    m_thread = new std::thread([this]{ fill(); });
+	}
+	catch (...) {
+	    s_registry.erase(this);
+	    throw;
+	}
+    }
+    catch (...) {
+	// Without a thread of its own, the reader calls the source.
+    }
+#ifndef _WIN32
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+#endif
+}
+
+ReadAhead::~ReadAhead()
+{
+    {
+	std::lock_guard<std::mutex> lock(s_registry_mutex);
+	s_registry.erase(this);
+    }
+    if (!m_thread)
+	return;
+    {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stopping = true;
+    }
+    m_drained.notify_all();
+    m_thread->join();
+    delete m_thread;
+}
+
+void ReadAhead::fill()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+	m_drained.wait(lock, [this]{
+		return m_stopping || m_full.size() < m_max_blocks;
+	    });
+	if (m_stopping)
+	    return;
+	std::vector<char> block;
+	if (!m_spare.empty()) {
+	    block.swap(m_spare.back());
+	    m_spare.pop_back();
+	}
+	m_reading = true;
+	lock.unlock();
+	std::ptrdiff_t n;
+	try {
+	    block.resize(m_block_size);
+	    n = m_source(block.data(), m_block_size);
+	}
+	catch (...) {
+	    n = -1;
+	}
+	lock.lock();
+	m_reading = false;
+	if (n <= 0) {
+	    m_eof = true;
+	    m_failed = (n < 0);
+	    m_filled.notify_all();
+	    return;
+	}
+	block.resize(n);
+	m_full.push_back(std::move(block));
+	m_filled.notify_all();
+    }
+}
+
+bool ReadAhead::nextBlock()
+{
+    if (m_at_end)
+	return false;
+    if (!m_thread) {
+	// No background thread: read the next block directly, after
+	// any left by the thread.
+	if (!m_full.empty()) {
+	    m_current.swap(m_full.front());
+	    m_full.pop_front();
+	} else {
+	    std::ptrdiff_t n = -1;
+	    if (!m_eof) {
+		m_current.resize(m_block_size);
+		n = m_source(m_current.data(), m_block_size);
+	    }
+	    if (n <= 0) {
+		m_failed = m_failed || (!m_eof && n < 0);
+		m_eof = m_at_end = true;
+		m_current.clear();
+		m_pos = 0;
+		return false;
+	    }
+	    m_current.resize(n);
+	}
+	m_pos = 0;
+	return true;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_current.capacity() > 0 && m_spare.size() < m_max_blocks) {
+	m_spare.push_back(std::vector<char>());
+	m_spare.back().swap(m_current);
+    }
+    m_filled.wait(lock, [this]{ return !m_full.empty() || m_eof; });
+    if (m_full.empty()) {
+	m_at_end = true;
+	m_current.clear();
+	m_pos = 0;
+	return false;
+    }
+    m_current.swap(m_full.front());
+    m_full.pop_front();
+    m_pos = 0;
+    lock.unlock();
+    m_drained.notify_one();
+    return true;
+}
+
+std::size_t ReadAhead::read(void* buf, std::size_t n)
+{
+    char* out = static_cast<char*>(buf);
+    std::size_t done = 0;
+    while (done < n) {
+	if (m_pos == m_current.size() && !nextBlock())
+	    break;
+	std::size_t k = std::min(n - done, m_current.size() - m_pos);
+	std::memcpy(out + done, m_current.data() + m_pos, k);
+	m_pos += k;
+	done += k;
+    }
+    m_consumed += double(done);
+    return done;
+}
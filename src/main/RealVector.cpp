@@ -29,6 +29,9 @@
 
 #include "rho/RealVector.hpp"
 
+#include "rho/GCRoot.hpp"
+#include "rho/ListVector.hpp"
+
 using namespace rho;
 
 // Force the creation of non-inline embodiments of functions callable
@@ -43,4 +46,20 @@ namespace rho {
     const char* RealVector::staticTypeName() {
 	return "numeric";
     }
+
+    RealVector* SmallRealVectors::s_table[SmallRealVectors::s_max
+					  - SmallRealVectors::s_min + 1];
+
+    void SmallRealVectors::initialize()
+    {
+	const int n = s_max - s_min + 1;
+	static GCRoot<ListVector> holder(ListVector::create(n));
+	for (int i = 0; i < n; ++i) {
+	    RealVector* scalar = RealVector::create(1);
+	    (*scalar)[0] = s_min + i;
+	    (*holder)[i] = scalar;
+	    MARK_NOT_MUTABLE(scalar);
+	    s_table[i] = scalar;
+	}
+    }
 }
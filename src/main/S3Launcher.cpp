@@ -29,8 +29,12 @@
 
 #include "rho/S3Launcher.hpp"
 
+#include <functional>
+
+#include "boost/functional/hash.hpp"
 #include "rho/Environment.hpp"
 #include "rho/FunctionBase.hpp"
+#include "rho/Symbol.hpp"
 
 using namespace std;
 using namespace rho;
@@ -108,6 +112,68 @@ S3Launcher::findMethod(const Symbol* symbol, Environment* call_env,
     return pair<FunctionBase*, bool>(nullptr, false);
 }
 
+namespace {
+    // Number of MethodNames cached.  The cache is direct-mapped.
+    const size_t METHOD_NAMES_CACHE_SIZE = 256;
+
+    bool sameClasses(const StringVector* lhs, const StringVector* rhs)
+    {
+	if (lhs->size() != rhs->size())
+	    return false;
+	for (unsigned int i = 0; i < lhs->size(); ++i)
+	    if ((*lhs)[i] != (*rhs)[i])
+		return false;
+	return true;
+    }
+}
+
+std::shared_ptr<const S3Launcher::MethodNames>
+S3Launcher::methodNames(const std::string& generic, const std::string& group,
+			const StringVector* classes)
+{
+    static std::shared_ptr<const MethodNames>* s_cache
+	= new std::shared_ptr<const MethodNames>[METHOD_NAMES_CACHE_SIZE];
+
+    // Class names that are not ASCII are translated into the native
+    // encoding, which may change, so the results are not cached.
+    bool cacheable = true;
+    size_t hash = std::hash<std::string>()(generic);
+    boost::hash_combine(hash, group);
+    for (unsigned int i = 0; i < classes->size(); ++i) {
+	const String* klass = (*classes)[i];
+	boost::hash_combine(hash, klass);
+	cacheable = cacheable && klass->isASCII();
+    }
+    std::shared_ptr<const MethodNames>* slot = nullptr;
+    if (cacheable) {
+	slot = &s_cache[hash % METHOD_NAMES_CACHE_SIZE];
+	const MethodNames* names = slot->get();
+	if (names && names->generic == generic && names->group == group
+	    && sameClasses(names->classes, classes))
+	    return *slot;
+    }
+
+    std::shared_ptr<MethodNames> names = std::make_shared<MethodNames>();
+    names->generic = generic;
+    names->group = group;
+    // Copied, because the class attribute of an object may later be
+    // modified in place.
+    names->classes = classes->clone();
+    for (unsigned int i = 0; i < classes->size(); ++i) {
+	const char* klass = Rf_translateChar((*classes)[i]);
+	names->generic_methods.push_back(
+	    Symbol::obtainS3Signature(generic.c_str(), klass));
+	if (!group.empty())
+	    names->group_methods.push_back(
+		Symbol::obtainS3Signature(group.c_str(), klass));
+    }
+    names->default_method
+	= Symbol::obtainS3Signature(generic.c_str(), "default");
+    if (slot)
+	*slot = names;
+    return names;
+}
+
 void S3Launcher::visitReferents(const_visitor* v) const
 {
     if (m_call_env)
@@ -30,9 +30,9 @@
 #include "rho/String.hpp"
 
 #include <algorithm>
-#include <boost/lambda/lambda.hpp>
 
 #include "rho/errors.hpp"
+#include "utf8scan.h"
 
 using namespace rho;
 
@@ -145,12 +145,7 @@ String::map* String::getCache()
 
 bool rho::isASCII(const std::string& str)
 {
-    using namespace boost::lambda;
-    // Beware of the iterator dereferencing to a *signed* char, hence
-    // the bitwise test:
-    std::string::const_iterator it
-	= std::find_if(str.begin(), str.end(), _1 & 0x80);
-    return it == str.end();
+    return R_ascii_span(str.data(), str.size()) == str.size();
 }
 
 String* String::obtain(const std::string& str, cetype_t encoding)
@@ -0,0 +1,233 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/** @file ThreadPool.cpp
+ *
+ * @brief Implementation of class rho::ThreadPool.
+ */
+
+#include "rho/ThreadPool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+using namespace rho;
+
+namespace {
+    // State shared between the thread calling run() and the workers.
+    // There is only ever one job in progress, since R code (and so
+    // every caller of run()) executes on a single thread.
+    struct Pool {
+	std::mutex m_mutex;
+	std::condition_variable m_work_ready;
+	std::condition_variable m_work_done;
+	std::vector<std::thread*> m_workers;
+
+	// The current job.  All but m_next are protected by m_mutex.
+	const std::function<void(std::size_t)>* m_task = nullptr;
+	std::size_t m_ntasks = 0;
+	std::atomic<std::size_t> m_next{0};
+	std::size_t m_helpers_wanted = 0;
+	std::size_t m_active = 0;
+	unsigned long m_generation = 0;
+	std::exception_ptr m_error;
+
+	void runTasks();
+	void workerLoop();
+	void ensureWorkers(std::size_t n);
+    };
+
+    // Null until first needed.  After a fork() the child's copy is
+    // abandoned, since none of its worker threads exist in the child.
+    Pool* s_pool = nullptr;
+
+    thread_local bool t_in_task = false;
+
+    // Set by ThreadPool::initialize().  This is the pool's own
+    // setting: R_num_math_threads, which governs the math threading
+    // in (for example) stats::dist, keeps its default.
+    unsigned int s_num_threads = 1;
+
+    // Marks the calling thread as running tasks for its lifetime.
+    class InTask {
+    public:
+	InTask() : m_saved(t_in_task)
+	{
+	    t_in_task = true;
+	}
+
+	~InTask()
+	{
+	    t_in_task = m_saved;
+	}
+    private:
+	bool m_saved;
+    };
+
+#ifndef _WIN32
+    void abandonPoolInChild()
+    {
+	s_pool = nullptr;
+	t_in_task = false;
+    }
+#endif
+}
+
+void Pool::runTasks()
+{
+    std::size_t i;
+    while ((i = m_next.fetch_add(1)) < m_ntasks) {
+	try {
+	    (*m_task)(i);
+	}
+	catch (...) {
+	    std::lock_guard<std::mutex> lock(m_mutex);
+	    if (!m_error)
+		m_error = std::current_exception();
+	}
+    }
+}
+
+void Pool::workerLoop()
+{
+    t_in_task = true;
+    unsigned long seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+	m_work_ready.wait(lock, [&]{
+		return m_generation != seen && m_helpers_wanted > 0;
+	    });
+	seen = m_generation;
+	--m_helpers_wanted;
+	++m_active;
+	lock.unlock();
+	runTasks();
+	lock.lock();
+	if (--m_active == 0)
+	    m_work_done.notify_all();
+    }
+}
+
+// Start workers until there are at least n.  Worker threads block
+// all signals, so that R's handlers continue to run on the main
+// thread.  Failure to start a thread is not an error: the work is
+// simply shared between fewer threads.
+void Pool::ensureWorkers(std::size_t n)
+{
+#ifndef _WIN32
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+#endif
+    try {
+	while (m_workers.size() < n)
+	    m_workers.push_back(new std::thread([this]{ workerLoop(); }));
+    }
+    catch (const std::system_error&) {
+    }
+#ifndef _WIN32
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+#endif
+}
+
+void ThreadPool::initialize()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    const char* env = std::getenv("OMP_NUM_THREADS");
+    if (env && std::atoi(env) > 0)
+	n = std::atoi(env);
+    if (n == 0)
+	n = 1;
+    s_num_threads = n;
+#ifndef _WIN32
+    pthread_atfork(nullptr, nullptr, abandonPoolInChild);
+#endif
+}
+
+unsigned int ThreadPool::numThreads()
+{
+    return s_num_threads;
+}
+
+bool ThreadPool::inWorker()
+{
+    return t_in_task;
+}
+
+void ThreadPool::run(std::size_t ntasks,
+		     const std::function<void(std::size_t)>& task)
+{
+    std::size_t nthreads = std::min<std::size_t>(numThreads(), ntasks);
+    if (nthreads > 1 && !t_in_task) {
+	if (!s_pool)
+	    s_pool = new Pool;
+	s_pool->ensureWorkers(nthreads - 1);
+	nthreads = std::min(nthreads, s_pool->m_workers.size() + 1);
+    }
+    if (nthreads <= 1 || t_in_task) {
+	InTask in_task;
+	for (std::size_t i = 0; i < ntasks; ++i)
+	    task(i);
+	return;
+    }
+
+    Pool* pool = s_pool;
+    {
+	std::lock_guard<std::mutex> lock(pool->m_mutex);
+	pool->m_task = &task;
+	pool->m_ntasks = ntasks;
+	pool->m_next = 0;
+	pool->m_error = nullptr;
+	pool->m_helpers_wanted = nthreads - 1;
+	++pool->m_generation;
+    }
+    pool->m_work_ready.notify_all();
+
+    {
+	InTask in_task;
+	pool->runTasks();
+    }
+
+    std::exception_ptr error;
+    {
+	std::unique_lock<std::mutex> lock(pool->m_mutex);
+	// Workers that have not yet woken up are no longer needed.
+	pool->m_helpers_wanted = 0;
+	pool->m_work_done.wait(lock, [&]{ return pool->m_active == 0; });
+	pool->m_task = nullptr;
+	std::swap(error, pool->m_error);
+    }
+    if (error)
+	std::rethrow_exception(error);
+}
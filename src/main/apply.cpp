@@ -29,7 +29,340 @@
 
 #include <Defn.h>
 #include <Internal.h>
+#include "apply.h"
+#include "arithmetic.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#include "rho/ArgList.hpp"
+#include "rho/BuiltInFunction.hpp"
+#include "rho/Closure.hpp"
 #include "rho/ExpressionVector.hpp"
+#include "rho/IntVector.hpp"
+#include "rho/Promise.hpp"
+#include "rho/RealVector.hpp"
+#include "rho/ThreadPool.hpp"
+
+using namespace rho;
+
+ElementApplier::ElementApplier(Expression* call, Environment* env,
+			       int num_varying)
+    : m_call(call), m_env(env), m_num_varying(num_varying),
+      m_values(ListVector::create(num_varying)), m_resolved(false),
+      m_direct(false)
+{}
+
+bool ElementApplier::isDirectlyIndexable(const RObject* x)
+{
+    if (!x || x->hasClass())
+	return false;
+    switch (x->sexptype()) {
+    case LGLSXP:
+    case INTSXP:
+    case REALSXP:
+    case CPLXSXP:
+    case STRSXP:
+    case RAWSXP:
+    case VECSXP:
+    case EXPRSXP:
+	return true;
+    default:
+	return false;
+    }
+}
+
+RObject* ElementApplier::element(RObject* x, R_xlen_t i)
+{
+    switch (TYPEOF(x)) {
+    case LGLSXP: {
+	SEXP ans = allocVector(LGLSXP, 1);
+	LOGICAL(ans)[0] = LOGICAL(x)[i];
+	return ans;
+    }
+    case INTSXP:
+	return ScalarInteger(INTEGER(x)[i]);
+    case REALSXP:
+	return ScalarReal(REAL(x)[i]);
+    case CPLXSXP:
+	return ScalarComplex(COMPLEX(x)[i]);
+    case STRSXP:
+	return ScalarString(STRING_ELT(x, i));
+    case RAWSXP:
+	return ScalarRaw(RAW(x)[i]);
+    default: {
+	// As in do_subset2, the element is still referenced by x.
+	SEXP ans = (TYPEOF(x) == EXPRSXP ? XVECTOR_ELT(x, i)
+		    : VECTOR_ELT(x, i));
+	if (NAMED(ans) < 2)
+	    SET_NAMED(ans, 2);
+	return ans;
+    }
+    }
+}
+
+void ElementApplier::resolve()
+{
+    m_resolved = true;
+    RObject* head = m_call->car();
+    RObject* fun;
+    if (TYPEOF(head) == SYMSXP)
+	fun = Rf_findFun(head, m_env);
+    else
+	fun = Rf_eval(head, m_env);
+    if (TYPEOF(fun) != CLOSXP && TYPEOF(fun) != BUILTINSXP)
+	return;
+    m_function = SEXP_downcast<FunctionBase*>(fun);
+
+    // '...' is expanded, and its promises taken, once for all calls.
+    const PairList* rest = m_call->tail();
+    for (int j = 0; j < m_num_varying; ++j)
+	rest = rest->tail();
+    ArgList constant_args(rest, ArgList::RAW);
+    if (TYPEOF(fun) == CLOSXP)
+	constant_args.wrapInPromises(m_env, m_call);
+    else
+	constant_args.evaluate(m_env);
+    m_constant_args = const_cast<PairList*>(constant_args.list());
+    m_direct = true;
+}
+
+PairList* ElementApplier::arguments(bool promised) const
+{
+    // The list is built afresh for every call, because the function
+    // called may alter it.
+    GCStackRoot<PairList> head(PairList::cons(nullptr));
+    PairList* last = head;
+    const PairList* arg = m_call->tail();
+    for (int j = 0; j < m_num_varying; ++j, arg = arg->tail()) {
+	RObject* value = (*m_values)[j];
+	if (promised)
+	    value = Promise::createEvaluatedPromise(arg->car(), value);
+	PairList* cell = PairList::cons(value, nullptr, arg->tag());
+	last->setTail(cell);
+	last = cell;
+    }
+    for (const PairList* c = m_constant_args; c; c = c->tail()) {
+	PairList* cell = PairList::cons(c->car(), nullptr, c->tag());
+	last->setTail(cell);
+	last = cell;
+    }
+    return head->tail();
+}
+
+RObject* ElementApplier::apply()
+{
+    if (!m_resolved)
+	resolve();
+    if (!m_direct)
+	return R_forceAndCall(m_call, m_num_varying, m_env);
+    if (TYPEOF(m_function) == CLOSXP) {
+	ArgList arglist(arguments(true), ArgList::PROMISED);
+	return m_call->invokeClosure(static_cast<Closure*>(m_function.get()),
+				     m_env, &arglist);
+    }
+    ArgList arglist(arguments(false), ArgList::EVALUATED);
+    return m_call->applyBuiltIn(
+	static_cast<BuiltInFunction*>(m_function.get()), m_env, &arglist);
+}
+
+std::unique_ptr<ScalarKernel> ElementApplier::scalarKernel()
+{
+    if (!m_resolved)
+	resolve();
+    if (!m_direct || m_num_varying != 1 || m_constant_args
+	|| TYPEOF(m_function) != CLOSXP)
+	return nullptr;
+    return ScalarKernel::compile(static_cast<Closure*>(m_function.get()));
+}
+
+namespace {
+    // Primitives that a ScalarKernel may call, with their arities
+    // (-1 for 1 or 2), and the opcodes for one and two arguments.
+    struct KernelPrimitive {
+	const char* name;
+	int arity;
+	int unary_opcode;
+	int binary_opcode;
+    };
+
+    // Elements evaluated at a time by each instruction.
+    const size_t KERNEL_BLOCK = 256;
+
+    // Fewest elements worth giving a thread of their own.
+    const size_t KERNEL_GRAIN = 1 << 14;
+}
+
+std::unique_ptr<ScalarKernel> ScalarKernel::compile(const Closure* func)
+{
+    const PairList* formals = func->matcher()->formalArgs();
+    if (func->debugging() || !formals || formals->tail()
+	|| formals->tag() == R_DotsSymbol)
+	return nullptr;
+    const Symbol* arg = static_cast<const Symbol*>(formals->tag());
+    std::unique_ptr<ScalarKernel> kernel(new ScalarKernel);
+    if (!kernel->compileExpression(func->body(), arg, func->environment(), 1))
+	return nullptr;
+    return kernel;
+}
+
+bool ScalarKernel::compileExpression(const RObject* expr, const Symbol* arg,
+				     Environment* env, size_t depth)
+{
+    static const KernelPrimitive primitives[] = {
+	{"(", 1, -1, -1}, {"{", 1, -1, -1},
+	{"+", -1, -1, ADD}, {"-", -1, NEG, SUB},
+	{"*", 2, -1, MUL}, {"/", 2, -1, DIV}, {"^", 2, -1, POW},
+	{"abs", 1, ABS, -1}, {"sqrt", 1, SQRT, -1}, {"exp", 1, EXP, -1},
+	{"log", 1, LOG, -1}, {"floor", 1, FLOOR, -1},
+	{"ceiling", 1, CEILING, -1}, {"sin", 1, SIN, -1},
+	{"cos", 1, COS, -1}, {"tan", 1, TAN, -1}
+    };
+
+    m_stack_depth = std::max(m_stack_depth, depth);
+    if (expr == arg) {
+	m_code.push_back({ARG, 0.0});
+	return true;
+    }
+    if (!expr)
+	return false;
+    switch (expr->sexptype()) {
+    case REALSXP: {
+	// Integer constants are not accepted: arithmetic on them alone
+	// gives integers, with NA and a warning on overflow.  With only
+	// double constants every subexpression is a double.
+	const RealVector* rv = static_cast<const RealVector*>(expr);
+	if (expr->attributes() || rv->size() != 1)
+	    return false;
+	m_code.push_back({CONST, (*rv)[0]});
+	return true;
+    }
+    case LANGSXP:
+	break;
+    default:
+	return false;
+    }
+
+    const Expression* call = static_cast<const Expression*>(expr);
+    if (!call->car() || call->car()->sexptype() != SYMSXP)
+	return false;
+    const Symbol* fsym = static_cast<const Symbol*>(call->car());
+    const KernelPrimitive* prim = nullptr;
+    for (const KernelPrimitive& p : primitives)
+	if (fsym->name()->stdstring() == p.name)
+	    prim = &p;
+    if (!prim)
+	return false;
+    // The symbol must still refer to the primitive of that name.
+    FunctionBase* fun = findFunction(fsym, env);
+    if (!fun || fun->sexptype() == CLOSXP
+	|| strcmp(static_cast<BuiltInFunction*>(fun)->name(), prim->name) != 0)
+	return false;
+
+    int nargs = 0;
+    for (const PairList* a = call->tail(); a; a = a->tail()) {
+	if (a->tag() || a->car() == R_DotsSymbol
+	    || a->car() == R_MissingArg)
+	    return false;
+	++nargs;
+    }
+    if (prim->arity == -1 ? (nargs < 1 || nargs > 2) : nargs != prim->arity)
+	return false;
+    const PairList* args = call->tail();
+    if (!compileExpression(args->car(), arg, env, depth))
+	return false;
+    if (nargs == 2) {
+	if (!compileExpression(args->tail()->car(), arg, env, depth + 1))
+	    return false;
+	m_code.push_back({Opcode(prim->binary_opcode), 0.0});
+    } else if (prim->unary_opcode != -1)
+	m_code.push_back({Opcode(prim->unary_opcode), 0.0});
+    return true;
+}
+
+// Each instruction is applied to a whole block of elements in turn,
+// so that the interpretive overhead is shared between them and the
+// inner loops can be vectorised.
+void ScalarKernel::runBlock(const double* in, double* out, size_t n,
+			    double* stack, bool* nan_produced) const
+{
+    double* top = stack - KERNEL_BLOCK;
+    for (const Instruction& instr : m_code) {
+	double* x = top;
+	double* y = top - KERNEL_BLOCK;
+	switch (instr.opcode) {
+	case ARG:
+	    top += KERNEL_BLOCK;
+	    std::copy(in, in + n, top);
+	    continue;
+	case CONST:
+	    top += KERNEL_BLOCK;
+	    std::fill(top, top + n, instr.constant);
+	    continue;
+	case NEG:
+	    for (size_t k = 0; k < n; ++k) x[k] = -x[k];
+	    continue;
+	case ADD:
+	    for (size_t k = 0; k < n; ++k) y[k] += x[k];
+	    break;
+	case SUB:
+	    for (size_t k = 0; k < n; ++k) y[k] -= x[k];
+	    break;
+	case MUL:
+	    for (size_t k = 0; k < n; ++k) y[k] *= x[k];
+	    break;
+	case DIV:
+	    for (size_t k = 0; k < n; ++k) y[k] /= x[k];
+	    break;
+	case POW:
+	    for (size_t k = 0; k < n; ++k) y[k] = R_POW(y[k], x[k]);
+	    break;
+	default: {
+	    double (*f)(double) = nullptr;
+	    switch (instr.opcode) {
+	    case ABS: f = fabs; break;
+	    case SQRT: f = sqrt; break;
+	    case EXP: f = exp; break;
+	    case LOG: f = R_log; break;
+	    case FLOOR: f = floor; break;
+	    case CEILING: f = ceil; break;
+	    case SIN: f = sin; break;
+	    case COS: f = cos; break;
+	    default: f = tan; break;
+	    }
+	    // As in math1(), NaNs from numbers call for a warning.
+	    for (size_t k = 0; k < n; ++k) {
+		double value = f(x[k]);
+		if (ISNAN(value) && !ISNAN(x[k]))
+		    *nan_produced = true;
+		x[k] = value;
+	    }
+	    continue;
+	}
+	}
+	// Binary operations pop their second operand.
+	top = y;
+    }
+    std::copy(top, top + n, out);
+}
+
+bool ScalarKernel::run(const double* in, double* out, R_xlen_t n) const
+{
+    std::atomic<bool> nan_produced(false);
+    size_t depth = m_stack_depth;
+    ThreadPool::parallelFor(n, KERNEL_GRAIN, [&](size_t b, size_t e) {
+	    std::vector<double> stack(depth*KERNEL_BLOCK);
+	    bool nan = false;
+	    for (size_t k = b; k < e && !nan; k += KERNEL_BLOCK)
+		runBlock(in + k, out + k, std::min(KERNEL_BLOCK, e - k),
+			 stack.data(), &nan);
+	    if (nan)
+		nan_produced = true;
+	});
+    return !nan_produced;
+}
 
 /* .Internal(lapply(X, FUN)) */
 
@@ -70,15 +403,36 @@ SEXP attribute_hidden do_lapply(SEXP call, SEXP op, SEXP args, SEXP rho)
     SEXP R_fcall = PROTECT(LCONS(FUN,
 				 CONS(tmp, CONS(R_DotsSymbol, R_NilValue))));
 
+    ElementApplier applier(SEXP_downcast<Expression*>(R_fcall),
+			   SEXP_downcast<Environment*>(rho), 1);
+    bool direct = ElementApplier::isDirectlyIndexable(XX);
+    SEXP values = R_NilValue;
+    if (direct && TYPEOF(XX) == REALSXP && n >= ScalarKernel::kMinLength) {
+	std::unique_ptr<ScalarKernel> kernel = applier.scalarKernel();
+	if (kernel) {
+	    values = allocVector(REALSXP, n);
+	    if (!kernel->run(REAL(XX), REAL(values), n))
+		values = R_NilValue;
+	}
+    }
+    PROTECT(values);
     for(R_xlen_t i = 0; i < n; i++) {
+	if (values != R_NilValue) {
+	    SET_VECTOR_ELT(ans, i, ScalarReal(REAL(values)[i]));
+	    continue;
+	}
 	if (realIndx) REAL(ind)[0] = (double)(i + 1);
 	else INTEGER(ind)[0] = (int)(i + 1);
-	tmp = R_forceAndCall(R_fcall, 1, rho);
+	if (direct) {
+	    applier.setArgument(0, ElementApplier::element(XX, i));
+	    tmp = applier.apply();
+	} else
+	    tmp = R_forceAndCall(R_fcall, 1, rho);
 	if (MAYBE_REFERENCED(tmp)) tmp = lazy_duplicate(tmp);
 	SET_VECTOR_ELT(ans, i, tmp);
     }
 
-    UNPROTECT(6);
+    UNPROTECT(7);
     return ans;
 }
 
@@ -154,13 +508,27 @@ SEXP attribute_hidden do_vapply(SEXP call, SEXP op, SEXP args, SEXP rho)
 	PROTECT(R_fcall = LCONS(FUN,
 				CONS(tmp, CONS(R_DotsSymbol, R_NilValue))));
 
+	ElementApplier applier(SEXP_downcast<Expression*>(R_fcall),
+			       SEXP_downcast<Environment*>(rho), 1);
+	bool direct = ElementApplier::isDirectlyIndexable(XX);
+	bool computed = false;
+	if (direct && TYPEOF(XX) == REALSXP && commonType == REALSXP
+	    && commonLen == 1 && n >= ScalarKernel::kMinLength) {
+	    std::unique_ptr<ScalarKernel> kernel = applier.scalarKernel();
+	    // Otherwise the loop below does it all again, with warnings.
+	    computed = (kernel && kernel->run(REAL(XX), REAL(ans), n));
+	}
 	int common_len_offset = 0;
-	for(i = 0; i < n; i++) {
+	for(i = 0; i < n && !computed; i++) {
 	    SEXP val; SEXPTYPE valType;
 	    PROTECT_INDEX indx;
 	    if (realIndx) REAL(ind)[0] = (double)(i + 1);
 	    else INTEGER(ind)[0] = (int)(i + 1);
-	    val = R_forceAndCall(R_fcall, 1, rho);
+	    if (direct) {
+		applier.setArgument(0, ElementApplier::element(XX, i));
+		val = applier.apply();
+	    } else
+		val = R_forceAndCall(R_fcall, 1, rho);
 	    if (MAYBE_REFERENCED(val))
 		val = lazy_duplicate(val); // Need to duplicate? Copying again anyway
 	    PROTECT_WITH_INDEX(val, &indx);
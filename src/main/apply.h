@@ -0,0 +1,143 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Repeated calls of a function with arguments drawn from vectors, as
+ * made by lapply(), vapply() and mapply(): see apply.cpp.
+ *
+ * Such calls are made through a call FUN(A1, ..., Am, ...) in which the
+ * first m arguments, A1 to Am, are subscripting expressions like
+ * X[[i]].  Evaluating it afresh for every element looks up FUN, expands
+ * '...', and dispatches on '[['.  An ElementApplier does the first two
+ * only once.  The caller extracts the elements itself, and the
+ * ElementApplier binds them as the values of already forced promises,
+ * whose expressions are still A1 to Am for the benefit of substitute()
+ * and sys.call().
+ *
+ * A ScalarKernel is a closure of one argument whose body only does
+ * arithmetic on that argument and on double constants.  Applied to the
+ * elements of a double vector, it has no side effects, and needs no
+ * evaluation by the interpreter, so it can run on ThreadPool.
+ */
+
+#ifndef APPLY_H
+#define APPLY_H 1
+
+#include <Defn.h>
+
+#include <memory>
+#include <vector>
+
+#include "rho/Closure.hpp"
+#include "rho/Expression.hpp"
+#include "rho/FunctionBase.hpp"
+#include "rho/GCStackRoot.hpp"
+#include "rho/ListVector.hpp"
+#include "rho/PairList.hpp"
+
+namespace rho {
+    class ScalarKernel {
+    public:
+	// Vectors shorter than this are not worth compiling for.
+	static const R_xlen_t kMinLength = 256;
+
+	// Returns null unless func has a single formal argument x, and
+	// its body is built only from x, scalar double constants, and
+	// calls of primitives among +, -, *, /, ^, (, {, abs, sqrt,
+	// exp, log, floor, ceiling, sin, cos and tan, as found from
+	// its environment.
+	static std::unique_ptr<ScalarKernel> compile(const Closure* func);
+
+	// out[k] = func(in[k]) for 0 <= k < n.  Returns false, leaving
+	// out partly written, if a mathematical function gave NaN for
+	// an argument that was not NaN: R must then be left to issue
+	// the warning.
+	bool run(const double* in, double* out, R_xlen_t n) const;
+    private:
+	enum Opcode {
+	    ARG, CONST, NEG, ADD, SUB, MUL, DIV, POW,
+	    ABS, SQRT, EXP, LOG, FLOOR, CEILING, SIN, COS, TAN
+	};
+
+	struct Instruction {
+	    Opcode opcode;
+	    double constant;
+	};
+
+	// The body in postfix order.
+	std::vector<Instruction> m_code;
+	size_t m_stack_depth;
+
+	ScalarKernel() : m_stack_depth(0) {}
+
+	bool compileExpression(const RObject* expr, const Symbol* arg,
+			       Environment* env, size_t depth);
+	void runBlock(const double* in, double* out, size_t n,
+		      double* stack, bool* nan_produced) const;
+    };
+
+    class ElementApplier {
+    public:
+	// call is FUN(A1, ..., Am, ...), where m is num_varying, to be
+	// evaluated in env.  Any variables that A1 to Am refer to must
+	// be kept up to date by the caller: they are still used if the
+	// call has to be evaluated in the ordinary way.
+	ElementApplier(Expression* call, Environment* env, int num_varying);
+
+	// Can elements of x be extracted by element() rather than by
+	// dispatching on '[['?
+	static bool isDirectlyIndexable(const RObject* x);
+
+	// x[[i + 1]], for x that isDirectlyIndexable().
+	static RObject* element(RObject* x, R_xlen_t i);
+
+	// Sets the value of argument Aj for the next apply().
+	void setArgument(int j, RObject* value)
+	{
+	    (*m_values)[j] = value;
+	}
+
+	// Calls FUN with the arguments set.  Functions other than
+	// closures and builtins are called as R_forceAndCall() would.
+	RObject* apply();
+
+	// The ScalarKernel form of FUN, if it is a closure that has one
+	// argument, is passed no others, and has that form.
+	std::unique_ptr<ScalarKernel> scalarKernel();
+    private:
+	GCStackRoot<Expression> m_call;
+	Environment* m_env;
+	int m_num_varying;
+	GCStackRoot<ListVector> m_values;
+	GCStackRoot<FunctionBase> m_function;
+	// Remaining arguments, promised for a closure and evaluated
+	// for a builtin.
+	GCStackRoot<PairList> m_constant_args;
+	bool m_resolved;
+	bool m_direct;
+
+	void resolve();
+	PairList* arguments(bool promised) const;
+    };
+}
+
+#endif /* APPLY_H */
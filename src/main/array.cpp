@@ -37,6 +37,8 @@
 #include <R_ext/Itermacros.h>
 
 #include "duplicate.h"
+#include "summation.h"
+#include "transpose.h"
 #include "rho/GCStackRoot.hpp"
 #include "rho/RAllocStack.hpp"
 #include "rho/Subscripting.hpp"
@@ -478,12 +480,52 @@ SEXP attribute_hidden do_rowscols(/*const*/ rho::Expression* call, const rho::Bu
     return ans;
 }
 
+/* Product of operands at least one of which contains NA or NaN, for
+ * which the BLAS cannot be trusted (PR#4582).  Small products use the
+ * straightforward triple loop with extended-precision accumulation.
+ * Larger ones are blocked so that a tile of x stays in cache while
+ * each column of z is updated by unit-stride axpy operations; no term
+ * is ever skipped, so NAs propagate exactly as in the simple loop.
+ */
+static void na_matprod(const double *x, int nrx, int ncx,
+		       const double *y, int nry, int ncy, double *z)
+{
+    const int ROWBLOCK = 256, COLBLOCK = 128;
+    R_xlen_t NRX = nrx, NRY = nry;
+
+    if (double(nrx) * ncx * ncy < 1e5) {
+	for (int i = 0; i < nrx; i++)
+	    for (int k = 0; k < ncy; k++) {
+		LDOUBLE sum = 0.0;
+		for (int j = 0; j < ncx; j++)
+		    sum += x[i + j * NRX] * y[j + k * NRY];
+		z[i + k * NRX] = double( sum);
+	    }
+	return;
+    }
+    for (R_xlen_t i = 0; i < NRX*ncy; i++) z[i] = 0;
+    for (int i0 = 0; i0 < nrx; i0 += ROWBLOCK) {
+	int ni = std::min(ROWBLOCK, nrx - i0);
+	for (int j0 = 0; j0 < ncx; j0 += COLBLOCK) {
+	    int j1 = std::min(j0 + COLBLOCK, ncx);
+	    for (int k = 0; k < ncy; k++) {
+		double* zk = z + i0 + k * NRX;
+		for (int j = j0; j < j1; j++) {
+		    const double* xj = x + i0 + j * NRX;
+		    double yjk = y[j + k * NRY];
+		    for (int i = 0; i < ni; i++)
+			zk[i] += xj[i] * yjk;
+		}
+	    }
+	}
+    }
+}
+
 static void matprod(double *x, int nrx, int ncx,
 		    double *y, int nry, int ncy, double *z)
 {
     RHOCONST char *transa = "N", *transb = "N";
     double one = 1.0, zero = 0.0;
-    LDOUBLE sum;
     Rboolean have_na = FALSE;
     R_xlen_t NRX = nrx, NRY = nry;
 
@@ -496,15 +538,9 @@ static void matprod(double *x, int nrx, int ncx,
 	if (!have_na)
 	    for (R_xlen_t i = 0; i < NRY*ncy; i++)
 		if (ISNAN(y[i])) {have_na = TRUE; break;}
-	if (have_na) {
-	    for (int i = 0; i < nrx; i++)
-		for (int k = 0; k < ncy; k++) {
-		    sum = 0.0;
-		    for (int j = 0; j < ncx; j++)
-			sum += x[i + j * NRX] * y[j + k * NRY];
-		    z[i + k * NRX] = double( sum);
-		}
-	} else
+	if (have_na)
+	    na_matprod(x, nrx, ncx, y, nry, ncy, z);
+	else
 	    F77_CALL(dgemm)(transa, transb, &nrx, &ncy, &ncx, &one,
 			    x, &nrx, y, &nry, &zero, z, &nrx);
     } else /* zero-extent operations should return zeroes */
@@ -1022,25 +1058,21 @@ SEXP attribute_hidden do_transpose(/*const*/ rho::Expression* call, const rho::B
     R_xlen_t i, j, l_1 = len-1;
     switch (TYPEOF(a)) {
     case LGLSXP:
+	R_transpose(LOGICAL(a), LOGICAL(r), ncol, nrow, nrow, ncol,
+		    sizeof(int));
+	break;
     case INTSXP:
-	// filling in columnwise, "accessing row-wise":
-        for (i = 0, j = 0; i < len; i++, j += nrow) {
-            if (j > l_1) j -= l_1;
-            INTEGER(r)[i] = INTEGER(a)[j];
-        }
-        break;
+	R_transpose(INTEGER(a), INTEGER(r), ncol, nrow, nrow, ncol,
+		    sizeof(int));
+	break;
     case REALSXP:
-        for (i = 0, j = 0; i < len; i++, j += nrow) {
-            if (j > l_1) j -= l_1;
-            REAL(r)[i] = REAL(a)[j];
-        }
-        break;
+	R_transpose(REAL(a), REAL(r), ncol, nrow, nrow, ncol,
+		    sizeof(double));
+	break;
     case CPLXSXP:
-        for (i = 0, j = 0; i < len; i++, j += nrow) {
-            if (j > l_1) j -= l_1;
-            COMPLEX(r)[i] = COMPLEX(a)[j];
-        }
-        break;
+	R_transpose(COMPLEX(a), COMPLEX(r), ncol, nrow, nrow, ncol,
+		    sizeof(Rcomplex));
+	break;
     case STRSXP:
         for (i = 0, j = 0; i < len; i++, j += nrow) {
             if (j > l_1) j -= l_1;
@@ -1054,11 +1086,8 @@ SEXP attribute_hidden do_transpose(/*const*/ rho::Expression* call, const rho::B
         }
         break;
     case RAWSXP:
-        for (i = 0, j = 0; i < len; i++, j += nrow) {
-            if (j > l_1) j -= l_1;
-            RAW(r)[i] = RAW(a)[j];
-        }
-        break;
+	R_transpose(RAW(a), RAW(r), ncol, nrow, nrow, ncol, 1);
+	break;
     default:
         UNPROTECT(1);
         error(_("argument is not a matrix"));
@@ -1189,32 +1218,19 @@ SEXP attribute_hidden do_aperm(/*const*/ rho::Expression* call, const rho::Built
     switch (TYPEOF(a)) {
 
     case INTSXP:
-	for (lj = 0, li = 0; li < len; li++) {
-	    INTEGER(r)[li] = INTEGER(a)[lj];
-	    CLICKJ;
-	}
+	R_aperm(INTEGER(a), INTEGER(r), n, isa, pp, sizeof(int));
 	break;
 
     case LGLSXP:
-	for (lj = 0, li = 0; li < len; li++) {
-	    LOGICAL(r)[li] = LOGICAL(a)[lj];
-	    CLICKJ;
-	}
+	R_aperm(LOGICAL(a), LOGICAL(r), n, isa, pp, sizeof(int));
 	break;
 
     case REALSXP:
-	for (lj = 0, li = 0; li < len; li++) {
-	    REAL(r)[li] = REAL(a)[lj];
-	    CLICKJ;
-	}
+	R_aperm(REAL(a), REAL(r), n, isa, pp, sizeof(double));
 	break;
 
     case CPLXSXP:
-	for (lj = 0, li = 0; li < len; li++) {
-	    COMPLEX(r)[li].r = COMPLEX(a)[lj].r;
-	    COMPLEX(r)[li].i = COMPLEX(a)[lj].i;
-	    CLICKJ;
-	}
+	R_aperm(COMPLEX(a), COMPLEX(r), n, isa, pp, sizeof(Rcomplex));
 	break;
 
     case STRSXP:
@@ -1232,10 +1248,7 @@ SEXP attribute_hidden do_aperm(/*const*/ rho::Expression* call, const rho::Built
 	break;
 
     case RAWSXP:
-	for (lj = 0, li = 0; li < len; li++) {
-	    RAW(r)[li] = RAW(a)[lj];
-	    CLICKJ;
-	}
+	R_aperm(RAW(a), RAW(r), n, isa, pp, 1);
 	break;
 
     default:
@@ -1295,7 +1308,7 @@ SEXP attribute_hidden do_colsum(/*const*/ rho::Expression* call, const rho::Buil
 {
     SEXP x, ans = R_NilValue;
     int type;
-    Rboolean NaRm, keepNA;
+    Rboolean NaRm;
 
     x = X_;
     R_xlen_t n = asVecSize(n_);
@@ -1306,7 +1319,6 @@ SEXP attribute_hidden do_colsum(/*const*/ rho::Expression* call, const rho::Buil
     if (p == NA_INTEGER || p < 0)
 	error(_("invalid '%s' argument"), "p");
     if (NaRm == NA_LOGICAL) error(_("invalid '%s' argument"), "na.rm");
-    keepNA = RHOCONSTRUCT(Rboolean, !NaRm);
 
     switch (type = TYPEOF(x)) {
     case LGLSXP:
@@ -1319,125 +1331,19 @@ SEXP attribute_hidden do_colsum(/*const*/ rho::Expression* call, const rho::Buil
     	error(_("'x' is too short")); /* PR#16367 */
 
     int OP = op->variant();
+    const void* px;
+    switch (type) {
+    case REALSXP: px = REAL(x); break;
+    case INTSXP: px = INTEGER(x); break;
+    default: px = LOGICAL(x); break;
+    }
     if (OP == 0 || OP == 1) { /* columns */
 	PROTECT(ans = allocVector(REALSXP, p));
-#ifdef _OPENMP
-	int nthreads;
-	/* This gives a spurious -Wunused-but-set-variable error */
-	if (R_num_math_threads > 0)
-	    nthreads = R_num_math_threads;
-	else
-	    nthreads = 1; /* for now */
-#pragma omp parallel for num_threads(nthreads) default(none) \
-    firstprivate(x, ans, n, p, type, NaRm, keepNA, R_NaReal, R_NaInt, OP)
-#endif
-	for (R_xlen_t j = 0; j < p; j++) {
-	    R_xlen_t  cnt = n, i;
-	    LDOUBLE sum = 0.0;
-	    switch (type) {
-	    case REALSXP:
-	    {
-		double *rx = REAL(x) + R_xlen_t(n)*j;
-		if (keepNA)
-		    for (sum = 0., i = 0; i < n; i++) sum += *rx++;
-		else {
-		    for (cnt = 0, sum = 0., i = 0; i < n; i++, rx++)
-			if (!ISNAN(*rx)) {cnt++; sum += *rx;}
-			else if (keepNA) {sum = NA_REAL; break;} // unused
-		}
-		break;
-	    }
-	    case INTSXP:
-	    {
-		int *ix = INTEGER(x) + R_xlen_t(n)*j;
-		for (cnt = 0, sum = 0., i = 0; i < n; i++, ix++)
-		    if (*ix != NA_INTEGER) {cnt++; sum += *ix;}
-		    else if (keepNA) {sum = NA_REAL; break;}
-		break;
-	    }
-	    case LGLSXP:
-	    {
-		int *ix = LOGICAL(x) + R_xlen_t(n)*j;
-		for (cnt = 0, sum = 0., i = 0; i < n; i++, ix++)
-		    if (*ix != NA_LOGICAL) {cnt++; sum += *ix;}
-		    else if (keepNA) {sum = NA_REAL; break;}
-		break;
-	    }
-	    }
-	    if (OP == 1) sum /= cnt; /* gives NaN for cnt = 0 */
-	    REAL(ans)[j] = double( sum);
-	}
+	R_colSums(SEXPTYPE(type), px, n, p, NaRm, OP == 1, REAL(ans));
     }
     else { /* rows */
 	PROTECT(ans = allocVector(REALSXP, n));
-
-	/* allocate scratch storage to allow accumulating by columns
-	   to improve cache hits */
-	int *Cnt = nullptr;
-	LDOUBLE *rans;
-	if(n <= 10000) {
-	    R_CheckStack2(n * sizeof(LDOUBLE));
-	    rans = static_cast<LDOUBLE *>( alloca(n * sizeof(LDOUBLE)));
-	    Memzero(rans, n);
-	} else rans = Calloc(n, LDOUBLE);
-	if (!keepNA && OP == 3) Cnt = Calloc(n, int);
-
-	for (R_xlen_t j = 0; j < p; j++) {
-	    LDOUBLE *ra = rans;
-	    switch (type) {
-	    case REALSXP:
-	    {
-		double *rx = REAL(x) + R_xlen_t(n) * j;
-		if (keepNA)
-		    for (R_xlen_t i = 0; i < n; i++) *ra++ += *rx++;
-		else
-		    for (R_xlen_t i = 0; i < n; i++, ra++, rx++)
-			if (!ISNAN(*rx)) {
-			    *ra += *rx;
-			    if (OP == 3) Cnt[i]++;
-			}
-		break;
-	    }
-	    case INTSXP:
-	    {
-		int *ix = INTEGER(x) + (R_xlen_t)n * j;
-		for (R_xlen_t i = 0; i < n; i++, ra++, ix++)
-		    if (keepNA) {
-			if (*ix != NA_INTEGER) *ra += *ix;
-			else *ra = NA_REAL;
-		    }
-		    else if (*ix != NA_INTEGER) {
-			*ra += *ix;
-			if (OP == 3) Cnt[i]++;
-		    }
-		break;
-	    }
-	    case LGLSXP:
-	    {
-		int *ix = LOGICAL(x) + (R_xlen_t)n * j;
-		for (R_xlen_t i = 0; i < n; i++, ra++, ix++)
-		    if (keepNA) {
-			if (*ix != NA_LOGICAL) *ra += *ix;
-			else *ra = NA_REAL;
-		    }
-		    else if (*ix != NA_LOGICAL) {
-			*ra += *ix;
-			if (OP == 3) Cnt[i]++;
-		    }
-		break;
-	    }
-	    }
-	}
-	if (OP == 3) {
-	    if (keepNA)
-		for (R_xlen_t i = 0; i < n; i++) rans[i] /= p;
-	    else
-		for (R_xlen_t i = 0; i < n; i++) rans[i] /= Cnt[i];
-	}
-	for (R_xlen_t i = 0; i < n; i++) REAL(ans)[i] = (double) rans[i];
-
-	if (!keepNA && OP == 3) Free(Cnt);
-	if(n > 10000) Free(rans);
+	R_rowSums(SEXPTYPE(type), px, n, p, NaRm, OP == 3, REAL(ans));
     }
 
     UNPROTECT(1);
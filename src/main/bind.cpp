@@ -42,6 +42,11 @@
 #include "rho/Closure.hpp"
 #include "rho/ExpressionVector.hpp"
 #include "rho/GCStackRoot.hpp"
+#include "rho/ThreadPool.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 using namespace std;
 using namespace rho;
@@ -308,7 +313,7 @@ StringAnswer(SEXP x, struct BindData *data, SEXP call)
 static void
 LogicalAnswer(SEXP x, struct BindData *data, SEXP call)
 {
-    R_xlen_t i;
+    R_xlen_t i, n = xlength(x);
     switch(TYPEOF(x)) {
     case NILSXP:
 	break;
@@ -327,19 +332,28 @@ LogicalAnswer(SEXP x, struct BindData *data, SEXP call)
 	    LogicalAnswer(VECTOR_ELT(x, i), data, call);
 	break;
     case LGLSXP:
-	for (i = 0; i < XLENGTH(x); i++)
-	    LOGICAL(data->ans_ptr)[data->ans_length++] = LOGICAL(x)[i];
+	std::copy_n(LOGICAL(x), n,
+		    LOGICAL(data->ans_ptr) + data->ans_length);
+	data->ans_length += n;
 	break;
-    case INTSXP:
-	for (i = 0; i < XLENGTH(x); i++) {
-	    int v = INTEGER(x)[i];
-	    LOGICAL(data->ans_ptr)[data->ans_length++] = (v == NA_INTEGER) ? NA_LOGICAL : ( v != 0 );
+    case INTSXP: {
+	const int* px = INTEGER(x);
+	int* pa = LOGICAL(data->ans_ptr) + data->ans_length;
+	for (i = 0; i < n; i++) {
+	    int v = px[i];
+	    pa[i] = (v == NA_INTEGER) ? NA_LOGICAL : ( v != 0 );
 	}
+	data->ans_length += n;
 	break;
-    case RAWSXP:
-	for (i = 0; i < XLENGTH(x); i++)
-	    LOGICAL(data->ans_ptr)[data->ans_length++] = (int)RAW(x)[i] != 0;
+    }
+    case RAWSXP: {
+	const Rbyte* px = RAW(x);
+	int* pa = LOGICAL(data->ans_ptr) + data->ans_length;
+	for (i = 0; i < n; i++)
+	    pa[i] = (int)px[i] != 0;
+	data->ans_length += n;
 	break;
+    }
     default:
 	errorcall(call, _("type '%s' is unimplemented in '%s'"),
 		  type2char(TYPEOF(x)), "LogicalAnswer");
@@ -349,7 +363,7 @@ LogicalAnswer(SEXP x, struct BindData *data, SEXP call)
 static void
 IntegerAnswer(SEXP x, struct BindData *data, SEXP call)
 {
-    R_xlen_t i;
+    R_xlen_t i, n = xlength(x);
     switch(TYPEOF(x)) {
     case NILSXP:
 	break;
@@ -368,16 +382,18 @@ IntegerAnswer(SEXP x, struct BindData *data, SEXP call)
 	    IntegerAnswer(VECTOR_ELT(x, i), data, call);
 	break;
     case LGLSXP:
-	for (i = 0; i < XLENGTH(x); i++)
-	    INTEGER(data->ans_ptr)[data->ans_length++] = LOGICAL(x)[i];
+	std::copy_n(LOGICAL(x), n,
+		    INTEGER(data->ans_ptr) + data->ans_length);
+	data->ans_length += n;
 	break;
     case INTSXP:
-	for (i = 0; i < XLENGTH(x); i++)
-	    INTEGER(data->ans_ptr)[data->ans_length++] = INTEGER(x)[i];
+	std::copy_n(INTEGER(x), n,
+		    INTEGER(data->ans_ptr) + data->ans_length);
+	data->ans_length += n;
 	break;
     case RAWSXP:
-	for (i = 0; i < XLENGTH(x); i++)
-	    INTEGER(data->ans_ptr)[data->ans_length++] = int(RAW(x)[i]);
+	std::copy_n(RAW(x), n, INTEGER(data->ans_ptr) + data->ans_length);
+	data->ans_length += n;
 	break;
     default:
 	errorcall(call, _("type '%s' is unimplemented in '%s'"),
@@ -388,7 +404,7 @@ IntegerAnswer(SEXP x, struct BindData *data, SEXP call)
 static void
 RealAnswer(SEXP x, struct BindData *data, SEXP call)
 {
-    R_xlen_t i;
+    R_xlen_t i, n = xlength(x);
     int xi;
     switch(TYPEOF(x)) {
     case NILSXP:
@@ -408,28 +424,23 @@ RealAnswer(SEXP x, struct BindData *data, SEXP call)
 	    RealAnswer(XVECTOR_ELT(x, i), data, call);
 	break;
     case REALSXP:
-	for (i = 0; i < XLENGTH(x); i++)
-	    REAL(data->ans_ptr)[data->ans_length++] = REAL(x)[i];
+	std::copy_n(REAL(x), n, REAL(data->ans_ptr) + data->ans_length);
+	data->ans_length += n;
 	break;
     case LGLSXP:
-	for (i = 0; i < XLENGTH(x); i++) {
-	    xi = LOGICAL(x)[i];
-	    if (xi == NA_LOGICAL)
-		REAL(data->ans_ptr)[data->ans_length++] = NA_REAL;
-	    else REAL(data->ans_ptr)[data->ans_length++] = xi;
-	}
-	break;
-    case INTSXP:
-	for (i = 0; i < XLENGTH(x); i++) {
-	    xi = INTEGER(x)[i];
-	    if (xi == NA_INTEGER)
-		REAL(data->ans_ptr)[data->ans_length++] = NA_REAL;
-	    else REAL(data->ans_ptr)[data->ans_length++] = xi;
+    case INTSXP: {
+	const int* px = (TYPEOF(x) == LGLSXP ? LOGICAL(x) : INTEGER(x));
+	double* pa = REAL(data->ans_ptr) + data->ans_length;
+	for (i = 0; i < n; i++) {
+	    xi = px[i];
+	    pa[i] = (xi == NA_INTEGER) ? NA_REAL : xi;
 	}
+	data->ans_length += n;
 	break;
+    }
     case RAWSXP:
-	for (i = 0; i < XLENGTH(x); i++)
-	    REAL(data->ans_ptr)[data->ans_length++] = int(RAW(x)[i]);
+	std::copy_n(RAW(x), n, REAL(data->ans_ptr) + data->ans_length);
+	data->ans_length += n;
 	break;
     default:
 	errorcall(call, _("type '%s' is unimplemented in '%s'"),
@@ -440,7 +451,7 @@ RealAnswer(SEXP x, struct BindData *data, SEXP call)
 static void
 ComplexAnswer(SEXP x, struct BindData *data, SEXP call)
 {
-    R_xlen_t i;
+    R_xlen_t i, n = xlength(x);
     int xi;
     switch(TYPEOF(x)) {
     case NILSXP:
@@ -467,8 +478,9 @@ ComplexAnswer(SEXP x, struct BindData *data, SEXP call)
 	}
 	break;
     case CPLXSXP:
-	for (i = 0; i < XLENGTH(x); i++)
-	    COMPLEX(data->ans_ptr)[data->ans_length++] = COMPLEX(x)[i];
+	std::copy_n(COMPLEX(x), n,
+		    COMPLEX(data->ans_ptr) + data->ans_length);
+	data->ans_length += n;
 	break;
     case LGLSXP:
 	for (i = 0; i < XLENGTH(x); i++) {
@@ -516,7 +528,7 @@ ComplexAnswer(SEXP x, struct BindData *data, SEXP call)
 static void
 RawAnswer(SEXP x, struct BindData *data, SEXP call)
 {
-    R_xlen_t i;
+    R_xlen_t i, n = xlength(x);
     switch(TYPEOF(x)) {
     case NILSXP:
 	break;
@@ -532,8 +544,8 @@ RawAnswer(SEXP x, struct BindData *data, SEXP call)
 	    RawAnswer(VECTOR_ELT(x, i), data, call);
 	break;
     case RAWSXP:
-	for (i = 0; i < XLENGTH(x); i++)
-	    RAW(data->ans_ptr)[data->ans_length++] = RAW(x)[i];
+	std::copy_n(RAW(x), n, RAW(data->ans_ptr) + data->ans_length);
+	data->ans_length += n;
 	break;
     default:
 	errorcall(call, _("type '%s' is unimplemented in '%s'"),
@@ -567,46 +579,80 @@ static SEXP NewBase(SEXP base, SEXP tag)
     return ans;
 }
 
-static SEXP NewName(SEXP base, SEXP tag, int seqno)
-{
-/* Construct a new Name/Tag, using
- *	base.tag
- *	base<seqno>	or
- *	tag
- *
- */
-
-    SEXP ans;
-    char *cbuf;
-    const void *vmax = vmaxget();
+namespace {
+    /* Constructs the names NewExtractNames() gives to the elements
+     * found under one base name:
+     *	base.tag
+     *	base<seqno>	or
+     *	tag
+     *
+     * The base is translated at most once, and each name is assembled
+     * in a buffer that is reused from one element to the next.
+     */
+    class NameMaker {
+    public:
+	explicit NameMaker(SEXP base)
+	    : m_base(EnsureString(base)), m_have_utf8(false),
+	      m_have_native(false)
+	{}
+
+	SEXP make(SEXP tag, int seqno);
+    private:
+	SEXP m_base;
+	std::string m_utf8, m_native;  // translations of m_base
+	bool m_have_utf8, m_have_native;
+	std::string m_buf;
+    };
+
+    void appendInt(std::string& buf, int n)
+    {
+	char digits[12];
+	char* p = digits + sizeof(digits);
+	unsigned int u = (n < 0 ? 0u - (unsigned int)(n) : (unsigned int)(n));
+	do {
+	    *--p = char('0' + u % 10);
+	    u /= 10;
+	} while (u);
+	if (n < 0)
+	    *--p = '-';
+	buf.append(p, digits + sizeof(digits));
+    }
+}
 
-    base = EnsureString(base);
+SEXP NameMaker::make(SEXP tag, int seqno)
+{
     tag = EnsureString(tag);
-    if (*CHAR(base) && *CHAR(tag)) {
-	const char *sb = translateCharUTF8(base), *st = translateCharUTF8(tag);
-	cbuf = static_cast<char*>(R_AllocStringBuffer(strlen(sb) + strlen(st) + 1, &cbuff));
-	sprintf(cbuf, "%s.%s", sb, st);
-	ans = mkCharCE(cbuf, CE_UTF8);
+    if (!*CHAR(m_base)) {
+	if (!*CHAR(tag))
+	    return R_BlankString;
+	/* Translation to UTF-8 would give back the same CHARSXP. */
+	if (tag == NA_STRING || IS_ASCII(tag) || IS_UTF8(tag))
+	    return tag;
+	const void *vmax = vmaxget();
+	SEXP ans = mkCharCE(translateCharUTF8(tag), CE_UTF8);
+	vmaxset(vmax);
+	return ans;
     }
-    else if (*CHAR(base)) {
-	const char *sb = translateChar(base);
-	cbuf = static_cast<char*>(R_AllocStringBuffer(strlen(sb) + size_t( IndexWidth(seqno)),
-						      &cbuff));
-	sprintf(cbuf, "%s%d", sb, seqno);
-	ans = mkCharCE(cbuf, CE_UTF8);
+    const void *vmax = vmaxget();
+    if (*CHAR(tag)) {
+	if (!m_have_utf8) {
+	    m_utf8 = translateCharUTF8(m_base);
+	    m_have_utf8 = true;
+	}
+	m_buf = m_utf8;
+	m_buf += '.';
+	m_buf += translateCharUTF8(tag);
     }
-    else if (*CHAR(tag)) {
-	if(tag == NA_STRING) ans = NA_STRING;
-	else {
-	    const char *st = translateCharUTF8(tag);
-	    cbuf = static_cast<char*>(R_AllocStringBuffer(strlen(st), &cbuff));
-	    sprintf(cbuf, "%s", st);
-	    ans = mkCharCE(cbuf, CE_UTF8);
+    else {
+	if (!m_have_native) {
+	    m_native = translateChar(m_base);
+	    m_have_native = true;
 	}
+	m_buf = m_native;
+	appendInt(m_buf, seqno);
     }
-    else ans = R_BlankString;
     vmaxset(vmax);
-    return ans;
+    return mkCharLenCE(m_buf.data(), int(m_buf.size()), CE_UTF8);
 }
 
 /* also used in coerce.c */
@@ -659,6 +705,7 @@ static void NewExtractNames(SEXP v, SEXP base, SEXP tag, int recurse,
 
     n = xlength(v);
     PROTECT(names = getAttrib(v, R_NamesSymbol));
+    NameMaker nameMaker(base);
 
     switch(TYPEOF(v)) {
     case NILSXP:
@@ -673,7 +720,7 @@ static void NewExtractNames(SEXP v, SEXP base, SEXP tag, int recurse,
 		if (namei == R_NilValue && nameData->count == 0)
 		    nameData->firstpos = data->ans_nnames;
 		nameData->count++;
-		namei = NewName(base, namei, ++(nameData->seqno));
+		namei = nameMaker.make(namei, ++(nameData->seqno));
 		SET_STRING_ELT(data->ans_names, (data->ans_nnames)++, namei);
 	    }
 	    v = CDR(v);
@@ -690,7 +737,7 @@ static void NewExtractNames(SEXP v, SEXP base, SEXP tag, int recurse,
 		if (namei == R_NilValue && nameData->count == 0)
 		    nameData->firstpos = data->ans_nnames;
 		nameData->count++;
-		namei = NewName(base, namei, ++(nameData->seqno));
+		namei = nameMaker.make(namei, ++(nameData->seqno));
 		SET_STRING_ELT(data->ans_names, (data->ans_nnames)++, namei);
 	    }
 	}
@@ -705,7 +752,7 @@ static void NewExtractNames(SEXP v, SEXP base, SEXP tag, int recurse,
 		if (namei == R_NilValue && nameData->count == 0)
 		    nameData->firstpos = data->ans_nnames;
 		nameData->count++;
-		namei = NewName(base, namei, ++(nameData->seqno));
+		namei = nameMaker.make(namei, ++(nameData->seqno));
 		SET_STRING_ELT(data->ans_names, (data->ans_nnames)++, namei);
 	    }
 	}
@@ -721,7 +768,7 @@ static void NewExtractNames(SEXP v, SEXP base, SEXP tag, int recurse,
 	    if (namei == R_NilValue && nameData->count == 0)
 		nameData->firstpos = data->ans_nnames;
 	    nameData->count++;
-	    namei = NewName(base, namei, ++(nameData->seqno));
+	    namei = nameMaker.make(namei, ++(nameData->seqno));
 	    SET_STRING_ELT(data->ans_names, (data->ans_nnames)++, namei);
 	}
 	break;
@@ -729,7 +776,7 @@ static void NewExtractNames(SEXP v, SEXP base, SEXP tag, int recurse,
 	if (nameData->count == 0)
 	    nameData->firstpos = data->ans_nnames;
 	nameData->count++;
-	namei = NewName(base, R_NilValue, ++(nameData->seqno));
+	namei = nameMaker.make(R_NilValue, ++(nameData->seqno));
 	SET_STRING_ELT(data->ans_names, (data->ans_nnames)++, namei);
     }
     if (tag != R_NilValue) {
@@ -1224,6 +1271,127 @@ static void SetColNames(SEXP dimnames, SEXP x)
 	SETCADR(dimnames, x);
 }
 
+/* Bulk filling of the logical, integer and double results of cbind()
+ * and rbind().  The layout of the result is first worked out as a list
+ * of the pieces the arguments contribute.  The copying that follows
+ * touches only the contents of vectors, so is shared out between the
+ * threads of rho::ThreadPool.  rbind() fills the result a column at a
+ * time, so that each column is written sequentially however many
+ * arguments contribute rows to it.
+ */
+
+namespace {
+    // Fewest result elements worth giving a thread of their own.
+    const R_xlen_t BIND_GRAIN = 1 << 16;
+
+    struct BindPiece {
+	SEXPTYPE type;	 // RAWSXP, LGLSXP, INTSXP or REALSXP
+	const void* src;
+	R_xlen_t start;	 // offset (cbind) or first row (rbind) in the result
+	R_xlen_t len;	 // elements (cbind) or rows (rbind) contributed
+	R_xlen_t nsrc;	 // length of the source, which is recycled
+    };
+
+    BindPiece makePiece(SEXP u, R_xlen_t start, R_xlen_t len)
+    {
+	BindPiece p;
+	p.type = TYPEOF(u);
+	p.start = start;
+	p.len = len;
+	p.nsrc = XLENGTH(u);
+	switch (p.type) {
+	case RAWSXP:
+	    p.src = RAW(u);
+	    break;
+	case LGLSXP:
+	    p.src = LOGICAL(u);
+	    break;
+	case INTSXP:
+	    p.src = INTEGER(u);
+	    break;
+	default:
+	    p.src = REAL(u);
+	}
+	return p;
+    }
+
+    // Element s of p's source, converted for a result of type mode.
+    inline void convertElt(int* dst, const BindPiece& p, R_xlen_t s,
+			   SEXPTYPE mode)
+    {
+	if (p.type == RAWSXP) {
+	    Rbyte b = static_cast<const Rbyte*>(p.src)[s];
+	    *dst = (mode == LGLSXP) ? (b ? TRUE : FALSE) : int(b);
+	}
+	else *dst = static_cast<const int*>(p.src)[s];
+    }
+
+    inline void convertElt(double* dst, const BindPiece& p, R_xlen_t s,
+			   SEXPTYPE)
+    {
+	if (p.type == REALSXP)
+	    *dst = static_cast<const double*>(p.src)[s];
+	else if (p.type == RAWSXP)
+	    *dst = static_cast<const Rbyte*>(p.src)[s];
+	else {
+	    int v = static_cast<const int*>(p.src)[s];
+	    *dst = (v == NA_INTEGER) ? NA_REAL : v;
+	}
+    }
+
+    inline bool sameType(int*, SEXPTYPE type)
+    {
+	return type == LGLSXP || type == INTSXP;
+    }
+
+    inline bool sameType(double*, SEXPTYPE type)
+    {
+	return type == REALSXP;
+    }
+
+    // dst[0, p.len) = elements s, s + 1, ... of p's source, recycled.
+    template <typename T>
+    void fillPiece(T* dst, const BindPiece& p, R_xlen_t s, SEXPTYPE mode)
+    {
+	if (s + p.len <= p.nsrc && sameType(dst, p.type)) {
+	    std::copy_n(static_cast<const T*>(p.src) + s, p.len, dst);
+	    return;
+	}
+	for (R_xlen_t i = 0; i < p.len; i++) {
+	    convertElt(dst + i, p, s, mode);
+	    if (++s == p.nsrc) s = 0;
+	}
+    }
+
+    template <typename T>
+    void cbindFill(T* dst, const std::vector<BindPiece>& pieces,
+		   R_xlen_t total, SEXPTYPE mode)
+    {
+	R_xlen_t np = R_xlen_t(pieces.size());
+	R_xlen_t grain = std::max(R_xlen_t(1),
+				  R_xlen_t(double(BIND_GRAIN) * np
+					   / std::max(total, R_xlen_t(1))));
+	ThreadPool::parallelFor(np, grain, [&](R_xlen_t b, R_xlen_t e) {
+		for (R_xlen_t k = b; k < e; k++)
+		    fillPiece(dst + pieces[k].start, pieces[k], 0, mode);
+	    });
+    }
+
+    template <typename T>
+    void rbindFill(T* dst, const std::vector<BindPiece>& pieces,
+		   R_xlen_t rows, R_xlen_t cols, SEXPTYPE mode)
+    {
+	R_xlen_t grain = std::max(R_xlen_t(1),
+				  BIND_GRAIN / std::max(rows, R_xlen_t(1)));
+	ThreadPool::parallelFor(cols, grain, [&](R_xlen_t b, R_xlen_t e) {
+		for (R_xlen_t j = b; j < e; j++)
+		    for (const BindPiece& p : pieces)
+			fillPiece(dst + p.start + j * rows, p,
+				  (j * p.len) % p.nsrc, mode);
+	    });
+    }
+}
+
 /*
  * Apparently i % 0 could occur here (PR#2541).  But it should not,
  * as zero-length vectors are ignored and
@@ -1386,48 +1554,22 @@ static SEXP cbind(SEXP call, SEXP args, SEXPTYPE mode, SEXP rho,
 	}
     }
     else { /* everything else, currently REALSXP, INTSXP, LGLSXP */
+	std::vector<BindPiece> pieces;
 	for (t = args; t != R_NilValue; t = CDR(t)) {
 	    u = PRVALUE(CAR(t)); /* type of u can be any of: RAW, LGL, INT, REAL */
 	    if (isMatrix(u) || length(u) >= lenmin) {
 		R_xlen_t k = XLENGTH(u);
 		R_xlen_t idx = (!isMatrix(u)) ? rows : k;
-		if (TYPEOF(u) <= INTSXP) { /* INT or LGL */
-		    if (mode <= INTSXP) {
-			xcopyIntegerWithRecycle(INTEGER(result), INTEGER(u),
-						n, idx, k);
-			n += idx;
-		    }
-		    else {
-			R_xlen_t i, i1;
-			MOD_ITERATE1(idx, k, i, i1, {
-			    REAL(result)[n++] =
-				(INTEGER(u)[i1]) == NA_INTEGER ? NA_REAL : INTEGER(u)[i1];
-			});
-		    }
-		}
-		else if (TYPEOF(u) == REALSXP) {
-		    xcopyRealWithRecycle(REAL(result), REAL(u), n, idx, k);
-		    n += idx;
-		}
-		else { /* RAWSXP */
-		    /* FIXME: I'm not sure what the author intended when the sequence was
-		       defined as raw < logical -- it is possible to represent logical as
-		       raw losslessly but not vice versa. So due to the way this was
-		       defined the raw -> logical conversion is bound to be lossy .. */
-		    if (mode == LGLSXP) {
-			R_xlen_t i, i1;
-			MOD_ITERATE1(idx, k, i, i1, {
-			    LOGICAL(result)[n++] = RAW(u)[i1] ? TRUE : FALSE;
-			});
-		    } else {
-			R_xlen_t i, i1;
-			MOD_ITERATE1(idx, k, i, i1, {
-			    INTEGER(result)[n++] = (unsigned char) RAW(u)[i1];
-			});
-		    }
-		}
+		if (idx > 0)
+		    pieces.push_back(makePiece(u, n, idx));
+		n += idx;
 	    }
 	}
+	if (mode == REALSXP)
+	    cbindFill(REAL(result), pieces, n, mode);
+	else
+	    cbindFill(mode == LGLSXP ? LOGICAL(result) : INTEGER(result),
+		      pieces, n, mode);
     }
 
     /* Adjustment of dimnames attributes. */
@@ -1628,41 +1770,22 @@ static SEXP rbind(SEXP call, SEXP args, SEXPTYPE mode, SEXP rho,
 	}
     }
     else { /* everything else, currently REALSXP, INTSXP, LGLSXP */
+	std::vector<BindPiece> pieces;
 	for (t = args; t != R_NilValue; t = CDR(t)) {
 	    u = PRVALUE(CAR(t)); /* type of u can be any of: RAW, LGL, INT, REAL */
 	    if (isMatrix(u) || length(u) >= lenmin) {
 		R_xlen_t k = XLENGTH(u);
 		R_xlen_t idx = (isMatrix(u)) ? nrows(u) : (k > 0);
-		if (TYPEOF(u) <= INTSXP) {
-		    if (mode <= INTSXP) {
-			xfillIntegerMatrixWithRecycle(INTEGER(result),
-						      INTEGER(u), n, rows,
-						      idx, cols, k);
-			n += idx;
-		    }
-		    else {
-			FILL_MATRIX_ITERATE(n, rows, idx, cols, k)
-			    REAL(result)[didx]
-				= (INTEGER(u)[sidx]) == NA_INTEGER ? NA_REAL : INTEGER(u)[sidx];
-			n += idx;
-		    }
-		}
-		else if (TYPEOF(u) == REALSXP) {
-		    xfillRealMatrixWithRecycle(REAL(result), REAL(u), n,
-					       rows, idx, cols, k);
-		    n += idx;
-		}
-		else { /* RAWSXP */
-		    if (mode == LGLSXP) {
-			FILL_MATRIX_ITERATE(n, rows, idx, cols, k)
-			    LOGICAL(result)[didx] = RAW(u)[sidx] ? TRUE : FALSE;
-		    }
-		    else
-			FILL_MATRIX_ITERATE(n, rows, idx, cols, k)
-			    INTEGER(result)[didx] = (unsigned char) RAW(u)[sidx];
-		}
+		if (idx > 0)
+		    pieces.push_back(makePiece(u, n, idx));
+		n += idx;
 	    }
 	}
+	if (mode == REALSXP)
+	    rbindFill(REAL(result), pieces, rows, cols, mode);
+	else
+	    rbindFill(mode == LGLSXP ? LOGICAL(result) : INTEGER(result),
+		      pieces, rows, cols, mode);
     }
 
     /* Adjustment of dimnames attributes. */
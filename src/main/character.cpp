@@ -101,6 +101,7 @@ using namespace rho;
  */
 
 #include "RBufferUtils.h"
+#include "utf8scan.h"
 static R_StringBuffer cbuff = {nullptr, 0, MAXELTSIZE};
 
 /* Functions to perform analogues of the standard C string library. */
@@ -158,17 +159,16 @@ int R_nchar(SEXP string, nchar_type type_,
 	return LENGTH(string);
 	break;
     case Chars:
+	if (IS_ASCII(string))
+	    return LENGTH(string);
 	if (IS_UTF8(string)) {
 	    const char *p = CHAR(string);
 	    if (!utf8Valid(p)) {
 		if (!allowNA)
 		    error(_("invalid multibyte string, %s"), msg_name);
 		return NA_INTEGER;
-	    } else {
-		int nc = 0;
-		for( ; *p; p += utf8clen(*p)) nc++;
-		return nc;
-	    }
+	    } else
+		return (int) R_utf8_count(p, LENGTH(string));
 	} else if (IS_BYTES(string)) {
 	    if (!allowNA) /* could do chars 0 */
 		error(_("number of characters is not computable in \"bytes\" encoding, %s"),
@@ -327,15 +327,31 @@ SEXP attribute_hidden do_substr(/*const*/ rho::Expression* call, const rho::Buil
 	    cetype_t ienc = getCharCE(el);
 	    const char *ss = CHAR(el);
 	    size_t slen = strlen(ss); /* FIXME -- should handle embedded nuls */
-	    char* buf = static_cast<char*>(R_AllocStringBuffer(slen+1, &cbuff));
 	    if (start < 1) start = 1;
 	    if (start > stop || start > RHOCONSTRUCT(int, slen)) {
-		buf[0] = '\0';
+		SET_STRING_ELT(s, i, mkCharCE("", ienc));
+		continue;
+	    }
+	    if (stop > RHOCONSTRUCT(int, slen)) stop = int( slen);
+	    /* ASCII and UTF-8 strings are sliced in place, and a
+	       substring that is the whole string is the string. */
+	    size_t b, e;
+	    if (IS_ASCII(el)) {
+		b = start - 1;
+		e = stop;
+	    } else if (ienc == CE_UTF8) {
+		b = R_utf8_advance(ss, slen, start - 1);
+		e = b + R_utf8_advance(ss + b, slen - b, stop - start + 1);
 	    } else {
-		if (stop > RHOCONSTRUCT(int, slen)) stop = int( slen);
+		char* buf = static_cast<char*>(R_AllocStringBuffer(slen+1, &cbuff));
 		substr(buf, ss, ienc, start, stop);
+		SET_STRING_ELT(s, i, mkCharCE(buf, ienc));
+		continue;
 	    }
-	    SET_STRING_ELT(s, i, mkCharCE(buf, ienc));
+	    if (b == 0 && e == slen)
+		SET_STRING_ELT(s, i, el);
+	    else
+		SET_STRING_ELT(s, i, mkCharLenCE(ss + b, int(e - b), ienc));
 	}
 	R_FreeStringBufferL(&cbuff);
     }
@@ -370,7 +386,7 @@ do_startsWith(rho::Expression* call, const rho::BuiltInFunction* op,
 	} else {
 	    // ASCII matching will do for ASCII Xfix except in non-UTF-8 MBCS
 	    Rboolean need_translate = TRUE;
-	    if (strIsASCII(CHAR(el)) && (utf8locale || !mbcslocale)) 
+	    if (IS_ASCII(el) && (utf8locale || !mbcslocale))
 		need_translate = FALSE;
 	    cp y0 = need_translate ? translateCharUTF8(el) : CHAR(el);
 	    int ylen = (int) strlen(y0);
@@ -457,7 +473,7 @@ substrset(char *buf, const char *const str, cetype_t ienc, int sa, int so)
     int i, in = 0, out = 0;
 
     if (ienc == CE_UTF8) {
-	for (i = 1; i < sa; i++) buf += utf8clen(*buf);
+	buf += R_utf8_advance(buf, strlen(buf), sa - 1);
 	for (i = sa; i <= so && in < strlen(str); i++) {
 	    in +=  utf8clen(str[in]);
 	    out += utf8clen(buf[out]);
@@ -544,7 +560,7 @@ SEXP attribute_hidden do_substrgets(/*const*/ rho::Expression* call, const rho::
 		   FIXME: could prefer UTF-8 here
 		 */
 		venc = getCharCE(v_el);
-		if (venc != ienc && !strIsASCII(v_ss)) {
+		if (venc != ienc && !IS_ASCII(v_el)) {
 		    ss = translateChar(el);
 		    slen = strlen(ss);
 		    v_ss = translateChar(v_el);
@@ -1542,6 +1558,18 @@ SEXP attribute_hidden do_strtrim(/*const*/ rho::Expression* call, const rho::Bui
 	    continue;
 	}
 	w = INTEGER(width)[i % nw];
+	if (IS_ASCII(STRING_ELT(x, i))) {
+	    /* Printable ASCII characters are one column each. */
+	    SEXP el = STRING_ELT(x, i);
+	    const char *cs = CHAR(el);
+	    nc = LENGTH(el);
+	    for (k = 0; k < nc && cs[k] >= 0x20 && cs[k] < 0x7f; k++) ;
+	    if (k == nc) {
+		SET_STRING_ELT(s, i, (w >= nc) ? el
+			       : mkCharLenCE(cs, w, CE_NATIVE));
+		continue;
+	    }
+	}
 	This = translateChar(STRING_ELT(x, i));
 	nc = int( strlen(This));
 	buf = static_cast<char*>(R_AllocStringBuffer(nc, &cbuff));
@@ -327,10 +327,9 @@ SEXP attribute_hidden Rf_StringFromLogical(int x, int *warn)
 
 SEXP attribute_hidden Rf_StringFromInteger(int x, int *warn)
 {
-    int w;
-    formatInteger(&x, 1, &w);
+    /* A lone integer needs no padding, so its width need not be found. */
     if (x == NA_INTEGER) return NA_STRING;
-    else return Rf_mkChar(EncodeInteger(x, w));
+    else return Rf_mkChar(EncodeInteger(x, 0));
 }
 
 // dropTrailing0 and StringFromReal moved to printutils.cpp
@@ -93,10 +93,16 @@
 #include <R_ext/RS.h>		/* R_chk_calloc and Free */
 #include <R_ext/Riconv.h>
 #include "basedecl.h"
+#include <algorithm>
 #include <cstdarg>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 #include "rho/ProvenanceTracker.hpp"
 #include "rho/RAllocStack.hpp"
+#include "rho/ReadAhead.hpp"
+#include "rho/ThreadPool.hpp"
 
 using namespace std;
 using namespace rho;
@@ -117,6 +123,10 @@ static void con_destroy(int i);
 # include <unistd.h>
 #endif
 
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+
 #ifdef HAVE_FCNTL_H
 # include <fcntl.h>
 /* Solaris and AIX define open as open64 under some circumstances */
@@ -565,11 +575,31 @@ void init_con(Rconnection newconn, const char *description, int enc,
 size_t Rf_utf8towcs(wchar_t *wc, const char *s, size_t n);
 #endif
 
+/* A file, gzfile or xzfile connection opened only for reading is read
+   by a rho::ReadAhead when several threads are allowed, so that the
+   next blocks of the file are read, and decompressed, while R works on
+   the last.  A seek other than a query of the position stops reading
+   ahead, and the connection is read directly from then on. */
+static bool can_read_ahead(Rconnection con)
+{
+    return con->canread && !con->canwrite && con->blocking
+	&& rho::ThreadPool::numThreads() > 1;
+}
+
+/* Pipes and terminals are left alone: reading them ahead could block
+   the thread indefinitely, and fork() waits for a read in progress. */
+static bool is_regular_file(const char *path)
+{
+    struct stat sb;
+    return stat(path, &sb) == 0 && S_ISREG(sb.st_mode);
+}
+
 typedef struct fileconn {
     FILE *fp;
     OFF_T rpos, wpos;
     Rboolean last_was_write;
     Rboolean raw;
+    rho::ReadAhead *ahead;
 #ifdef Win32
     Rboolean anon_file;
     char name[PATH_MAX+1];
@@ -640,6 +670,7 @@ static Rboolean file_open(Rconnection con)
     thisconn->anon_file = temp;
 #endif
     thisconn->fp = fp;
+    thisconn->ahead = nullptr;
     con->isopen = TRUE;
     con->canwrite = RHOCONSTRUCT(Rboolean, (con->mode[0] == 'w' || con->mode[0] == 'a'));
     con->canread = RHOCONSTRUCT(Rboolean, !con->canwrite);
@@ -661,12 +692,23 @@ static Rboolean file_open(Rconnection con)
 	fcntl(fd, F_SETFL, flags);
     }
 #endif
+    /* Only regular files are read ahead: see is_regular_file(). */
+    struct stat sb;
+    if(can_read_ahead(con) && strcmp(name, "stdin")
+       && fstat(fileno(fp), &sb) == 0 && S_ISREG(sb.st_mode))
+	thisconn->ahead = new rho::ReadAhead([fp](void *buf, size_t n) {
+		size_t nread = fread(buf, 1, n, fp);
+		return (nread == 0 && ferror(fp)) ? ptrdiff_t(-1)
+		    : ptrdiff_t(nread);
+	    });
     return TRUE;
 }
 
 static void file_close(Rconnection con)
 {
     Rfileconn thisconn = RHO_S_CAST(fileconn*, con->connprivate);
+    delete thisconn->ahead;
+    thisconn->ahead = nullptr;
     if(con->isopen && strcmp(con->description, "stdin"))
 	con->status = fclose(thisconn->fp);
     con->isopen = FALSE;
@@ -694,6 +736,7 @@ static int file_fgetc_internal(Rconnection con)
     FILE *fp = thisconn->fp;
     int c;
 
+    if(thisconn->ahead) return thisconn->ahead->getc();
     if(thisconn->last_was_write) {
 	thisconn->wpos = f_tell(thisconn->fp);
 	thisconn->last_was_write = FALSE;
@@ -710,6 +753,13 @@ static double file_seek(Rconnection con, double where, int origin, int rw)
     OFF_T pos;
     int whence = SEEK_SET;
 
+    if(thisconn->ahead) {
+	if(ISNA(where)) return thisconn->ahead->consumed();
+	pos = OFF_T(thisconn->ahead->consumed());
+	delete thisconn->ahead;
+	thisconn->ahead = nullptr;
+	f_seek(fp, pos, SEEK_SET);
+    }
     /* make sure both positions are set */
     pos = f_tell(fp);
     if(thisconn->last_was_write) thisconn->wpos = pos; else thisconn->rpos = pos;
@@ -775,6 +825,7 @@ static int file_fflush(Rconnection con)
 {
     FILE *fp = (static_cast<Rfileconn>((con->connprivate)))->fp;
 
+    if((static_cast<Rfileconn>((con->connprivate)))->ahead) return 0;
     return fflush(fp);
 }
 
@@ -784,6 +835,8 @@ static size_t file_read(void *ptr, size_t size, size_t nitems,
     Rfileconn thisconn = RHO_S_CAST(fileconn*, con->connprivate);
     FILE *fp = thisconn->fp;
 
+    if(thisconn->ahead)
+	return thisconn->ahead->read(ptr, size*nitems)/size;
     if(thisconn->last_was_write) {
 	thisconn->wpos = f_tell(thisconn->fp);
 	thisconn->last_was_write = FALSE;
@@ -841,6 +894,7 @@ static Rconnection newfile(const char *description, int enc, const char *mode,
 	error(_("allocation of file connection failed"));
     }
     (static_cast<Rfileconn>(newconn->connprivate))->raw = RHOCONSTRUCT(Rboolean, raw);
+    (static_cast<Rfileconn>(newconn->connprivate))->ahead = nullptr;
     return newconn;
 }
 
@@ -1378,6 +1432,7 @@ newpipe(const char *description, int ienc, const char *mode)
 	free(newconn->description); free(newconn->connclass); free(newconn);
 	error(_("allocation of pipe connection failed"));
     }
+    (static_cast<Rfileconn>(newconn->connprivate))->ahead = nullptr;
     return newconn;
 }
 
@@ -1474,11 +1529,99 @@ typedef struct gzconn {
 } *Rgzconn;
 
 
+/* When several threads are available, a gzfile opened for writing
+   is written as in pigz: the data are cut into blocks of GZ_BLOCK
+   bytes, each compressed by a thread of rho::ThreadPool as a gzip
+   member of its own, and the members are written in order.  gunzip,
+   like R_gzread(), reads such a multi-member file as the
+   concatenation of its members. */
+
+#define GZ_BLOCK (1 << 20)
+
+typedef struct gzblocks {
+    FILE *fp;
+    std::vector<Bytef> in;	/* data not yet compressed */
+    double pos;			/* total bytes written */
+    Rboolean empty;		/* no member has been written */
+} *Rgzblocks;
+
 typedef struct gzfileconn {
     gzFile fp;
     int compress;
+    Rgzblocks blocks;		/* non-null if writing in blocks */
+    rho::ReadAhead *ahead;	/* non-null if reading ahead */
 } *Rgzfileconn;
 
+/* Compresses in to a gzip member in *out.  Run by pool threads, so
+   reports failure by its return value. */
+static bool gz_deflate_member(const Bytef *in, size_t n, int level,
+			      std::string *out)
+{
+    z_stream strm;
+    memset(&strm, 0, sizeof strm);
+    /* 16 + MAX_WBITS asks for a gzip header and trailer. */
+    if (deflateInit2(&strm, level, Z_DEFLATED, 16 + MAX_WBITS, 8,
+		     Z_DEFAULT_STRATEGY) != Z_OK)
+	return false;
+    out->resize(deflateBound(&strm, uLong(n)));
+    strm.next_in = const_cast<Bytef *>(in);
+    strm.avail_in = uInt(n);
+    strm.next_out = reinterpret_cast<Bytef *>(&(*out)[0]);
+    strm.avail_out = uInt(out->size());
+    int res = deflate(&strm, Z_FINISH);
+    out->resize(out->size() - strm.avail_out);
+    deflateEnd(&strm);
+    return res == Z_STREAM_END;
+}
+
+/* Compresses and writes the whole blocks held, or if final is true
+   everything held, a batch of blocks at a time. */
+static void gz_write_blocks(Rgzblocks gz, int level, bool final)
+{
+    size_t nin = gz->in.size();
+    size_t nblocks = final ? (nin + GZ_BLOCK - 1) / GZ_BLOCK : nin / GZ_BLOCK;
+    if (final && nblocks == 0 && gz->empty)
+	nblocks = 1;		/* a valid file holds at least one member */
+    if (nblocks == 0)
+	return;
+    std::vector<std::string> members(nblocks);
+    std::vector<char> ok(nblocks);
+    rho::ThreadPool::run(nblocks, [&](size_t k) {
+	    size_t begin = k * GZ_BLOCK;
+	    size_t n = std::min(nin - begin, size_t(GZ_BLOCK));
+	    ok[k] = gz_deflate_member(gz->in.data() + begin, n, level,
+				      &members[k]);
+	});
+    gz->in.erase(gz->in.begin(),
+		 gz->in.begin() + std::min(nin, nblocks * GZ_BLOCK));
+    gz->empty = FALSE;
+    for (size_t k = 0; k < nblocks; k++) {
+	if (!ok[k])
+	    error(_("compression of gzfile block failed"));
+	if (fwrite(members[k].data(), 1, members[k].size(), gz->fp)
+	    != members[k].size())
+	    error(_("write error on gzfile connection"));
+    }
+}
+
+static size_t gz_blocks_write(Rgzfileconn gzcon, const void *ptr, size_t n)
+{
+    Rgzblocks gz = gzcon->blocks;
+    const Bytef *p = static_cast<const Bytef *>(ptr);
+    /* Blocks are compressed once there is one for every thread. */
+    size_t batch = size_t(GZ_BLOCK) * rho::ThreadPool::numThreads();
+    for (size_t left = n; left > 0;) {
+	size_t take = std::min(left, batch - std::min(batch, gz->in.size()));
+	gz->in.insert(gz->in.end(), p, p + take);
+	gz->pos += double(take);
+	p += take;
+	left -= take;
+	if (gz->in.size() >= batch)
+	    gz_write_blocks(gz, gzcon->compress, false);
+    }
+    return n;
+}
+
 static Rboolean gzfile_open(Rconnection con)
 {
     gzFile fp;
@@ -1491,11 +1634,28 @@ static Rboolean gzfile_open(Rconnection con)
     else if (con->mode[0] == 'a') snprintf(mode, 6, "ab%1d", gzcon->compress);
     else strcpy(mode, "rb");
     errno = 0; /* precaution */
-    fp = R_gzopen(R_ExpandFileName(con->description), mode);
-    if(!fp) {
-	warning(_("cannot open compressed file '%s', probable reason '%s'"),
-		R_ExpandFileName(con->description), strerror(errno));
-	return FALSE;
+    gzcon->blocks = nullptr;
+    gzcon->ahead = nullptr;
+    if(mode[0] != 'r' && rho::ThreadPool::numThreads() > 1) {
+	FILE *bfp = R_fopen(R_ExpandFileName(con->description),
+			    mode[0] == 'a' ? "ab" : "wb");
+	if(!bfp) {
+	    warning(_("cannot open compressed file '%s', probable reason '%s'"),
+		    R_ExpandFileName(con->description), strerror(errno));
+	    return FALSE;
+	}
+	gzcon->blocks = new gzblocks;
+	gzcon->blocks->fp = bfp;
+	gzcon->blocks->pos = 0;
+	gzcon->blocks->empty = TRUE;
+	fp = nullptr;
+    } else {
+	fp = R_gzopen(R_ExpandFileName(con->description), mode);
+	if(!fp) {
+	    warning(_("cannot open compressed file '%s', probable reason '%s'"),
+		    R_ExpandFileName(con->description), strerror(errno));
+	    return FALSE;
+	}
     }
     (static_cast<Rgzfileconn>((con->connprivate)))->fp = fp;
     con->isopen = TRUE;
@@ -1504,20 +1664,51 @@ static Rboolean gzfile_open(Rconnection con)
     con->text = strchr(con->mode, 'b') ? FALSE : TRUE;
     set_iconv(con);
     con->save = -1000;
+    if(fp && can_read_ahead(con)
+       && is_regular_file(R_ExpandFileName(con->description)))
+	gzcon->ahead = new rho::ReadAhead([fp](void *buf, size_t n) {
+		return ptrdiff_t(R_gzread_quiet(fp, buf, unsigned(n)));
+	    });
     return TRUE;
 }
 
 static void gzfile_close(Rconnection con)
 {
-    R_gzclose((static_cast<Rgzfileconn>((con->connprivate)))->fp);
+    Rgzfileconn gzcon = static_cast<Rgzfileconn>(con->connprivate);
+    delete gzcon->ahead;
+    gzcon->ahead = nullptr;
+    if(gzcon->blocks) {
+	Rgzblocks gz = gzcon->blocks;
+	gzcon->blocks = nullptr;
+	con->isopen = FALSE;
+	try {
+	    gz_write_blocks(gz, gzcon->compress, true);
+	} catch (...) {
+	    fclose(gz->fp);
+	    delete gz;
+	    throw;
+	}
+	int res = fclose(gz->fp);
+	delete gz;
+	if(res != 0)
+	    warning(_("problem closing connection:  %s"), strerror(errno));
+	return;
+    }
+    R_gzclose(gzcon->fp);
     con->isopen = FALSE;
 }
 
 static int gzfile_fgetc_internal(Rconnection con)
 {
-    gzFile fp = (static_cast<Rgzfileconn>((con->connprivate)))->fp;
+    Rgzfileconn gzcon = static_cast<Rgzfileconn>(con->connprivate);
+    gzFile fp = gzcon->fp;
     unsigned char c;
 
+    if (gzcon->ahead) {
+	int ch = gzcon->ahead->getc();
+	if (ch < 0 && gzcon->ahead->failed()) R_gzwarn(fp);
+	return ch < 0 ? R_EOF : ch;
+    }
     return R_gzread(fp, &c, 1) == 1 ? c : R_EOF;
 }
 
@@ -1525,7 +1716,34 @@ static int gzfile_fgetc_internal(Rconnection con)
    When reading, it either seeks forwards of rewinds and reads again */
 static double gzfile_seek(Rconnection con, double where, int origin, int rw)
 {
-    gzFile  fp = (static_cast<Rgzfileconn>((con->connprivate)))->fp;
+    Rgzfileconn gzcon = static_cast<Rgzfileconn>(con->connprivate);
+    if (gzcon->blocks) {
+	double pos = gzcon->blocks->pos;
+	if (ISNA(where)) return pos;
+	if (origin == 3)
+	    error(_("whence = \"end\" is not implemented for gzfile connections"));
+	double target = (origin == 2) ? pos + where : where;
+	if (target < pos)
+	    warning(_("seek on a gzfile connection returned an internal error"));
+	else {
+	    std::vector<Bytef> zeros(size_t(std::min(target - pos,
+						     double(GZ_BLOCK))));
+	    while (gzcon->blocks->pos < target) {
+		size_t n = size_t(std::min(target - gzcon->blocks->pos,
+					   double(zeros.size())));
+		gz_blocks_write(gzcon, zeros.data(), n);
+	    }
+	}
+	return pos;
+    }
+    gzFile  fp = gzcon->fp;
+    if (gzcon->ahead) {
+	double consumed = gzcon->ahead->consumed();
+	if (ISNA(where)) return consumed;
+	delete gzcon->ahead;
+	gzcon->ahead = nullptr;
+	R_gzseek(fp, z_off_t(consumed), SEEK_SET);
+    }
     Rz_off_t pos = R_gztell(fp);
     int res, whence = SEEK_SET;
 
@@ -1550,7 +1768,13 @@ static int gzfile_fflush(Rconnection con)
 static size_t gzfile_read(void *ptr, size_t size, size_t nitems,
 			Rconnection con)
 {
-    gzFile fp = (static_cast<Rgzfileconn>((con->connprivate)))->fp;
+    Rgzfileconn gzcon = static_cast<Rgzfileconn>(con->connprivate);
+    gzFile fp = gzcon->fp;
+    if (gzcon->ahead) {
+	size_t n = gzcon->ahead->read(ptr, size*nitems);
+	if (n < size*nitems && gzcon->ahead->failed()) R_gzwarn(fp);
+	return n/size;
+    }
     /* uses 'unsigned' for len */
     if (double( size) * double( nitems) > UINT_MAX)
 	error(_("too large a block specified"));
@@ -1560,7 +1784,10 @@ static size_t gzfile_read(void *ptr, size_t size, size_t nitems,
 static size_t gzfile_write(const void *ptr, size_t size, size_t nitems,
 			   Rconnection con)
 {
-    gzFile fp = (static_cast<Rgzfileconn>((con->connprivate)))->fp;
+    Rgzfileconn gzcon = static_cast<Rgzfileconn>(con->connprivate);
+    if (gzcon->blocks)
+	return gz_blocks_write(gzcon, ptr, size*nitems)/size;
+    gzFile fp = gzcon->fp;
     /* uses 'unsigned' for len */
     if (double( size) * double( nitems) > UINT_MAX)
 	error(_("too large a block specified"));
@@ -1602,6 +1829,8 @@ static Rconnection newgzfile(const char *description, const char *mode,
 	error(_("allocation of gzfile connection failed"));
     }
     static_cast<Rgzfileconn>(newconn->connprivate)->compress = compress;
+    static_cast<Rgzfileconn>(newconn->connprivate)->blocks = nullptr;
+    static_cast<Rgzfileconn>(newconn->connprivate)->ahead = nullptr;
     return newconn;
 }
 
@@ -1788,6 +2017,17 @@ static Rconnection newbzfile(const char *description, const char *mode,
 
 #include <lzma.h>
 
+/* With several threads, liblzma's threaded encoder writes an xzfile
+   as a stream of independently compressed blocks, and its threaded
+   decoder (liblzma 5.4 and later) reads such streams a block per
+   thread.  The threads are limited so that together they use at most
+   a quarter of physical memory. */
+static uint64_t xz_threads_memlimit(void)
+{
+    uint64_t mem = lzma_physmem() / 4;
+    return mem ? mem : (uint64_t(1) << 30);
+}
+
 typedef struct xzfileconn {
     FILE *fp;
     lzma_stream stream;
@@ -1797,8 +2037,13 @@ typedef struct xzfileconn {
     lzma_filter filters[2];
     lzma_options_lzma opt_lzma;
     unsigned char buf[BUFSIZE];
+    lzma_ret status;		/* why reading ahead stopped */
+    rho::ReadAhead *ahead;	/* non-null if reading ahead */
 } *Rxzfileconn;
 
+static size_t xz_read_quiet(Rxzfileconn xz, void *ptr, size_t s,
+			    lzma_ret *ret);
+
 static Rboolean xzfile_open(Rconnection con)
 {
     Rxzfileconn xz = RHO_S_CAST(Rxzfileconn, con->connprivate);
@@ -1822,6 +2067,18 @@ static Rboolean xzfile_open(Rconnection con)
 	/* probably about 80Mb is required, but 512Mb seems OK as a limit */
 	if (xz->type == 1)
 	    ret = lzma_alone_decoder(&xz->stream, 536870912);
+#if LZMA_VERSION >= 50040002
+	else if (rho::ThreadPool::numThreads() > 1) {
+	    lzma_mt mt;
+	    memset(&mt, 0, sizeof mt);
+	    mt.flags = LZMA_CONCATENATED;
+	    mt.threads = rho::ThreadPool::numThreads();
+	    mt.memlimit_threading = xz_threads_memlimit();
+	    mt.memlimit_stop = std::max(mt.memlimit_threading,
+					uint64_t(536870912));
+	    ret = lzma_stream_decoder_mt(&xz->stream, &mt);
+	}
+#endif
 	else
 	    ret = lzma_stream_decoder(&xz->stream, 536870912,
 				      LZMA_CONCATENATED);
@@ -1830,6 +2087,7 @@ static Rboolean xzfile_open(Rconnection con)
 	    return FALSE;
 	}
 	xz->stream.avail_in = 0;
+	xz->status = LZMA_OK;
     } else {
 	lzma_stream *strm = &xz->stream;
 	uint32_t preset_number = abs(xz->compress);
@@ -1840,7 +2098,23 @@ static Rboolean xzfile_open(Rconnection con)
 	xz->filters[0].options = &(xz->opt_lzma);
 	xz->filters[1].id = LZMA_VLI_UNKNOWN;
 
-	ret = lzma_stream_encoder(strm, xz->filters, LZMA_CHECK_CRC32);
+	uint32_t nthreads = 1;
+#if LZMA_VERSION >= 50020002
+	lzma_mt mt;
+	memset(&mt, 0, sizeof mt);
+	mt.filters = xz->filters;
+	mt.check = LZMA_CHECK_CRC32;
+	mt.threads = nthreads = rho::ThreadPool::numThreads();
+	/* Each thread holds a block of input and its own dictionary. */
+	while (mt.threads > 1
+	       && lzma_stream_encoder_mt_memusage(&mt) > xz_threads_memlimit())
+	    mt.threads--;
+	nthreads = mt.threads;
+	if (nthreads > 1)
+	    ret = lzma_stream_encoder_mt(strm, &mt);
+#endif
+	if (nthreads <= 1)
+	    ret = lzma_stream_encoder(strm, xz->filters, LZMA_CHECK_CRC32);
 	if (ret != LZMA_OK) {
 	    warning(_("cannot initialize lzma encoder, error %d"), ret);
 	    return FALSE;
@@ -1850,6 +2124,17 @@ static Rboolean xzfile_open(Rconnection con)
     con->text = strchr(con->mode, 'b') ? FALSE : TRUE;
     set_iconv(con);
     con->save = -1000;
+    xz->ahead = nullptr;
+    if(can_read_ahead(con)
+       && is_regular_file(R_ExpandFileName(con->description)))
+	xz->ahead = new rho::ReadAhead([xz](void *buf, size_t n) {
+		if (xz->status != LZMA_OK)
+		    return ptrdiff_t(xz->status == LZMA_STREAM_END ? 0 : -1);
+		size_t nread = xz_read_quiet(xz, buf, n, &xz->status);
+		if (nread == 0 && xz->status != LZMA_OK)
+		    return ptrdiff_t(xz->status == LZMA_STREAM_END ? 0 : -1);
+		return ptrdiff_t(nread);
+	    });
     return TRUE;
 }
 
@@ -1857,6 +2142,9 @@ static void xzfile_close(Rconnection con)
 {
     Rxzfileconn xz = RHO_S_CAST(Rxzfileconn, con->connprivate);
 
+    delete xz->ahead;
+    xz->ahead = nullptr;
+
     if(con->canwrite) {
 	lzma_ret ret;
 	lzma_stream *strm = &(xz->stream);
@@ -1876,15 +2164,18 @@ static void xzfile_close(Rconnection con)
     con->isopen = FALSE;
 }
 
-static size_t xzfile_read(void *ptr, size_t size, size_t nitems,
-			  Rconnection con)
+/* Decompresses up to s bytes into ptr, returning the number of bytes
+   decompressed.  *ret is LZMA_OK if all s bytes were decompressed,
+   and otherwise the result that stopped decompression.  Does not warn,
+   so can be run on a thread other than R's. */
+static size_t xz_read_quiet(Rxzfileconn xz, void *ptr, size_t s,
+			    lzma_ret *ret)
 {
-    Rxzfileconn xz = RHO_S_CAST(Rxzfileconn, con->connprivate);
     lzma_stream *strm = &(xz->stream);
-    lzma_ret ret;
-    size_t s = size*nitems, have, given = 0;
+    size_t have, given = 0;
     unsigned char *p = RHO_S_CAST(unsigned char*, ptr);
 
+    *ret = LZMA_OK;
     if (!s) return 0;
 
     while(1) {
@@ -1894,34 +2185,57 @@ static size_t xzfile_read(void *ptr, size_t size, size_t nitems,
 	    if (feof(xz->fp)) xz->action = LZMA_FINISH;
 	}
 	strm->avail_out = s; strm->next_out = p;
-	ret = lzma_code(strm, xz->action);
+	lzma_ret res = lzma_code(strm, xz->action);
 	have = s - strm->avail_out;  given += have;
 	//printf("available: %d, ready: %d/%d\n", strm->avail_in, given, s);
-	if (ret != LZMA_OK) {
-	    if (ret != LZMA_STREAM_END) {
-		switch(ret) {
-		case LZMA_MEM_ERROR:
-		case LZMA_MEMLIMIT_ERROR:
-		    warning("lzma decoder needed more memory");
-		    break;
-		case LZMA_FORMAT_ERROR:
-		    warning("lzma decoder format error");
-		    break;
-		case LZMA_DATA_ERROR:
-		    warning("lzma decoder corrupt data");
-		    break;
-		default:
-		    warning("lzma decoding result %d", ret);
-		}
-	    }
-	    return given/size;
+	if (res != LZMA_OK) {
+	    *ret = res;
+	    return given;
 	}
 	s -= have;
-	if (!s) return nitems;
+	if (!s) return given;
 	p += have;
     }
 }
 
+static void xz_warn(lzma_ret ret)
+{
+    switch(ret) {
+    case LZMA_OK:
+    case LZMA_STREAM_END:
+	break;
+    case LZMA_MEM_ERROR:
+    case LZMA_MEMLIMIT_ERROR:
+	warning("lzma decoder needed more memory");
+	break;
+    case LZMA_FORMAT_ERROR:
+	warning("lzma decoder format error");
+	break;
+    case LZMA_DATA_ERROR:
+	warning("lzma decoder corrupt data");
+	break;
+    default:
+	warning("lzma decoding result %d", ret);
+    }
+}
+
+static size_t xzfile_read(void *ptr, size_t size, size_t nitems,
+			  Rconnection con)
+{
+    Rxzfileconn xz = RHO_S_CAST(Rxzfileconn, con->connprivate);
+    size_t s = size*nitems, given;
+
+    if (xz->ahead) {
+	given = xz->ahead->read(ptr, s);
+	if (given < s && xz->ahead->failed()) xz_warn(xz->status);
+	return given/size;
+    }
+    lzma_ret ret;
+    given = xz_read_quiet(xz, ptr, s, &ret);
+    xz_warn(ret);
+    return given/size;
+}
+
 static int xzfile_fgetc_internal(Rconnection con)
 {
     char buf[1];
@@ -3516,6 +3830,142 @@ int Rconn_printf(Rconnection con, const char *format, ...)
 
 /* readLines(con = stdin(), n = 1, ok = TRUE, warn = TRUE) */
 #define BUF_SIZE 1000
+
+/* Block-buffered input for readLines().
+
+   Reading through Rconn_fgetc() costs an indirect call, and for the
+   compressed connections a call into the decompressor, per byte.
+   Connections whose read() method delivers the same bytes as their
+   fgetc() method, i.e. those with no re-encoding, can instead be read
+   in large blocks in which line ends are found by memchr().
+
+   Bytes are read ahead of the lines returned, and there is nowhere to
+   put them back, so the block reader is only used when the connection
+   is closed afterwards or the rest of its input is wanted.
+*/
+static bool readLines_can_block(Rconnection con, Rboolean wasopen,
+				R_xlen_t n)
+{
+    if(wasopen && n >= 0) return false;
+    if(con->inconv || con->nPushBack > 0 || con->save != -1000 ||
+       con->save2 != -1000 || !con->blocking)
+	return false;
+    const char *cls = con->connclass;
+    return streql(cls, "file") || streql(cls, "gzfile") ||
+	streql(cls, "bzfile") || streql(cls, "xzfile") ||
+	streql(cls, "rawConnection");
+}
+
+namespace {
+    class LineBlockReader {
+    public:
+	explicit LineBlockReader(Rconnection con)
+	    : m_con(con), m_buf(s_block_size), m_begin(0), m_end(0),
+	      m_cr(npos), m_cr_scanned(0), m_after_cr(false), m_eof(false)
+	{}
+
+	/* Finds the next line, which is left in place, without its
+	   terminator, at *line for *len bytes.  Line ends are mapped as
+	   by Rconn_fgetc(): CR and CRLF end a line as LF does, and a CR
+	   following a CR is taken to be a LF.  Returns false at the end
+	   of the input, when *len is the length of any incomplete final
+	   line. */
+	bool next(char **line, size_t *len)
+	{
+	    if(m_after_cr) {
+		m_after_cr = false;
+		if(m_begin == m_end) fill();
+		if(m_begin < m_end && m_buf[m_begin] == '\n')
+		    m_begin++;
+		else if(m_begin < m_end && m_buf[m_begin] == '\r') {
+		    *line = &m_buf[m_begin++];
+		    *len = 0;
+		    return true;
+		}
+	    }
+	    size_t searched = m_begin;
+	    for(;;) {
+		const void *nl = memchr(&m_buf[searched], '\n',
+					m_end - searched);
+		size_t end = nl ? static_cast<const char*>(nl) - &m_buf[0]
+		    : npos;
+		size_t cr = nextCR();
+		if(cr < end) end = cr;
+		if(end != npos) {
+		    *line = &m_buf[m_begin];
+		    *len = end - m_begin;
+		    m_after_cr = (m_buf[end] == '\r');
+		    m_begin = end + 1;
+		    return true;
+		}
+		size_t partial = m_end - m_begin;
+		if(!fill()) {
+		    *line = &m_buf[m_begin];
+		    *len = partial;
+		    m_begin = m_end;
+		    return false;
+		}
+		searched = m_begin + partial;
+	    }
+	}
+
+    private:
+	static const size_t s_block_size = 1 << 18;
+	static const size_t npos = size_t(-1);
+
+	Rconnection m_con;
+	std::vector<char> m_buf;
+	size_t m_begin, m_end;  // Unconsumed bytes.
+	// Position of the next CR, if any, and the extent searched for it.
+	size_t m_cr, m_cr_scanned;
+	bool m_after_cr, m_eof;
+
+	// Position of the first CR at or after m_begin, or npos.  The
+	// search is resumed where it last stopped, so that each byte is
+	// examined once however long the lines.
+	size_t nextCR()
+	{
+	    if(m_cr != npos && m_cr >= m_begin) return m_cr;
+	    size_t from = max(m_begin, m_cr_scanned);
+	    const void *p = (from < m_end)
+		? memchr(&m_buf[from], '\r', m_end - from) : nullptr;
+	    if(p) {
+		m_cr = static_cast<const char*>(p) - &m_buf[0];
+		m_cr_scanned = m_cr + 1;
+	    } else {
+		m_cr = npos;
+		m_cr_scanned = m_end;
+	    }
+	    return m_cr;
+	}
+
+	// Moves the unconsumed bytes to the front of the buffer,
+	// enlarging it if they fill it, and reads another block after
+	// them.  Returns false at the end of the input.
+	bool fill()
+	{
+	    if(m_eof) return false;
+	    size_t shift = m_begin;
+	    if(shift > 0) {
+		memmove(&m_buf[0], &m_buf[shift], m_end - shift);
+		m_begin = 0;
+		m_end -= shift;
+		m_cr = (m_cr != npos && m_cr >= shift) ? m_cr - shift : npos;
+		m_cr_scanned = (m_cr_scanned > shift) ? m_cr_scanned - shift : 0;
+	    }
+	    if(m_end == m_buf.size())
+		m_buf.resize(2 * m_buf.size());
+	    size_t want = m_buf.size() - m_end;
+	    size_t got = m_con->read(&m_buf[m_end], 1, want, m_con);
+	    if(got == 0 || got > want) {
+		m_eof = true;
+		return false;
+	    }
+	    m_end += got;
+	    return true;
+	}
+    };
+}
 SEXP attribute_hidden do_readLines(/*const*/ rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* con_, rho::RObject* n_, rho::RObject* ok_, rho::RObject* warn_, rho::RObject* encoding_, rho::RObject* skipNul_)
 {
     SEXP ans = R_NilValue, ans2;
@@ -3576,6 +4026,58 @@ SEXP attribute_hidden do_readLines(/*const*/ rho::Expression* call, const rho::B
 	nn = (n < 0) ? 1000 : n; /* initially allocate space for 1000 lines */
 	nnn = (n < 0) ? R_XLEN_T_MAX : n;
 	PROTECT(ans = allocVector(STRSXP, nn));
+	if(readLines_can_block(con, wasopen, n)) {
+	    LineBlockReader reader(con);
+	    for(nread = 0; nread < nnn; nread++) {
+		char *line;
+		size_t len;
+		bool complete = reader.next(&line, &len);
+		/* As in the loop below, a final line of only nuls is no
+		   line at all. */
+		if(skipNul)
+		    len = std::remove(line, line + len, '\0') - line;
+		if(!complete && len == 0) {
+		    nbuf = 0;
+		    goto no_more_lines;
+		}
+		if(nread >= nn) {
+		    double dnn = 2.* nn;
+		    if (dnn > R_XLEN_T_MAX) error("too many items");
+		    ans2 = allocVector(STRSXP, 2*nn);
+		    for(i = 0; i < nn; i++)
+			SET_STRING_ELT(ans2, i, STRING_ELT(ans, i));
+		    nn *= 2;
+		    UNPROTECT(1); /* old ans */
+		    PROTECT(ans = ans2);
+		}
+		const void *nul = skipNul ? nullptr : memchr(line, '\0', len);
+		if(nul) {
+		    len = static_cast<const char*>(nul) - line;
+		    if(warn)
+			warning(_("line %d appears to contain an embedded nul"),
+				nread + 1);
+		}
+		/* Remove UTF-8 BOM */
+		const char *qline = line;
+		if (nread == 0 && utf8locale && len >= 3 &&
+		    !memcmp(line, "\xef\xbb\xbf", 3)) {
+		    qline += 3;
+		    len -= 3;
+		}
+		if(len > INT_MAX)
+		    error(_("line longer than buffer size"));
+		SET_STRING_ELT(ans, nread, mkCharLenCE(qline, int(len), oenc));
+		if(!complete) {
+		    nbuf = 1; /* incomplete last line */
+		    goto no_more_lines;
+		}
+	    }
+	    if(!wasopen) con->close(con);
+	    UNPROTECT(1);
+	    free(buf);
+	    ProvenanceTracker::flagXenogenesis();
+	    return ans;
+	}
 	for(nread = 0; nread < nnn; nread++) {
 	    if(nread >= nn) {
 		double dnn = 2.* nn;
@@ -3732,6 +4234,65 @@ static void swapb(void *result, int size)
     }
 }
 
+/* swapb() for each of the n elements of the given size at p.  The
+   loops for each size are in a form that compilers recognize as byte
+   swaps, and vectorize. */
+static void swapBlock(void *p, R_xlen_t n, int size)
+{
+    char *c = RHO_S_CAST(char*, p);
+    R_xlen_t i;
+
+    switch(size) {
+    case 1:
+	break;
+    case 2:
+	for (i = 0; i < n; i++) {
+	    uint16_t v;
+	    memcpy(&v, c + 2*i, 2);
+	    v = uint16_t((v >> 8) | (v << 8));
+	    memcpy(c + 2*i, &v, 2);
+	}
+	break;
+    case 4:
+	for (i = 0; i < n; i++) {
+	    uint32_t v;
+	    memcpy(&v, c + 4*i, 4);
+	    v = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000)
+		| (v << 24);
+	    memcpy(c + 4*i, &v, 4);
+	}
+	break;
+    case 8:
+	for (i = 0; i < n; i++) {
+	    uint64_t v;
+	    memcpy(&v, c + 8*i, 8);
+	    v = ((v & 0x00ff00ff00ff00ffULL) << 8)
+		| ((v >> 8) & 0x00ff00ff00ff00ffULL);
+	    v = ((v & 0x0000ffff0000ffffULL) << 16)
+		| ((v >> 16) & 0x0000ffff0000ffffULL);
+	    v = (v << 32) | (v >> 32);
+	    memcpy(c + 8*i, &v, 8);
+	}
+	break;
+    default:
+	for (i = 0; i < n; i++) swapb(c + size*i, size);
+    }
+}
+
+/* Converts n elements of type T at in to the elements of out. */
+template <typename T, typename R>
+static void convertBlock(R *out, const char *in, R_xlen_t n)
+{
+    for (R_xlen_t i = 0; i < n; i++) {
+	T v;
+	memcpy(&v, in + sizeof(T)*i, sizeof(T));
+	out[i] = R(v);
+    }
+}
+
+/* Most bytes handed to the connection by one read in readBin(). */
+#define READBIN_BYTES (1 << 20)
+
 static SEXP readOneString(Rconnection con)
 {
     char buf[10001], *p;
@@ -3793,7 +4354,6 @@ static SEXP rawOneString(Rbyte *bytes, R_xlen_t nbytes, R_xlen_t *np)
 }
 
 /* readBin(con, what, n, swap) */
-#define BLOCK 8096
 SEXP attribute_hidden do_readbin(/*const*/ rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* con_, rho::RObject* what_, rho::RObject* n_, rho::RObject* size_, rho::RObject* signed_, rho::RObject* endian_)
 {
     SEXP ans = R_NilValue, swhat;
@@ -3843,7 +4403,13 @@ SEXP attribute_hidden do_readbin(/*const*/ rho::Expression* call, const rho::Bui
     }
 
     try {
-	if(!strcmp(what, "character")) {
+	if(isRaw && !strcmp(what, "raw") && (size == NA_INTEGER || size == 1)
+	   && n >= nbytes && ATTRIB(con_) == R_NilValue) {
+	    /* All of a raw vector without attributes, as raw: it is
+	       returned as it is. */
+	    PROTECT(ans = con_);
+	    m = n = nbytes;
+	} else if(!strcmp(what, "character")) {
 	    SEXP onechar;
 	    PROTECT(ans = allocVector(STRSXP, n));
 	    for(i = 0, m = 0; i < n; i++) {
@@ -3865,10 +4431,10 @@ SEXP attribute_hidden do_readbin(/*const*/ rho::Expression* call, const rho::Bui
 	    } else {
 		/* Do this in blocks to avoid large buffers in the connection */
 		char *pp = RHO_S_CAST(char*, p);
-		R_xlen_t m0, n0 = n;
+		R_xlen_t m0, n0 = n, nblock = READBIN_BYTES/size;
 		m = 0;
 		while(n0) {
-		    size_t n1 = (n0 < BLOCK) ? n0 : BLOCK;
+		    size_t n1 = (n0 < nblock) ? n0 : nblock;
 		    m0 = con->read(pp, size, n1, con);
 		    if (m0 < 0) error("error reading from the connection");
 		    m += m0;
@@ -3877,11 +4443,7 @@ SEXP attribute_hidden do_readbin(/*const*/ rho::Expression* call, const rho::Bui
 		    pp += n1 * size;
 		}
 	    }
-	    if(swap)
-		for(i = 0; i < m; i++) {
-		    swapb(&(COMPLEX(ans)[i].r), sizeof(double));
-		    swapb(&(COMPLEX(ans)[i].i), sizeof(double));
-		}
+	    if(swap) swapBlock(p, 2*m, sizeof(double));
 	} else {
 	    if (!strcmp(what, "integer") || !strcmp(what, "int")) {
 		sizedef = sizeof(int); mode = 1;
@@ -3954,12 +4516,13 @@ SEXP attribute_hidden do_readbin(/*const*/ rho::Expression* call, const rho::Bui
 		if(isRaw) {
 		    m = rawRead(RHO_S_CAST(char*, p), size, n, bytes, nbytes, &np);
 		} else {
-		    /* Do this in blocks to avoid large buffers in the connection */
+		    /* Do this in blocks to avoid large buffers in the
+		       connection, reading straight into the vector */
 		    char *pp = RHO_S_CAST(char*, p);
-		    R_xlen_t m0, n0 = n;
+		    R_xlen_t m0, n0 = n, nblock = READBIN_BYTES/size;
 		    m = 0;
 		    while(n0) {
-			size_t n1 = (n0 < BLOCK) ? n0 : BLOCK;
+			size_t n1 = (n0 < nblock) ? n0 : nblock;
 			m0 = con->read(pp, size, n1, con);
 			m += m0;
 			if (m0 < 0) error("error reading from the connection");
@@ -3968,70 +4531,54 @@ SEXP attribute_hidden do_readbin(/*const*/ rho::Expression* call, const rho::Bui
 			pp += n1 * size;
 		    }
 		}
-		if(swap && size > 1)
-		    for(i = 0; i < m; i++) swapb(static_cast<char *>(p)+i*size, size);
+		if(swap && size > 1) swapBlock(p, m, size);
 	    } else {
-		union {
-		    char buf[16];
-		    signed char signed_char_value;
-		    unsigned char unsigned_char_value;
-		    short short_value;
-		    unsigned short unsigned_short_value;
-		    long long_value;
-		    _lli_t lli_t_value;
-		    float float_value;
-#ifdef HAVE_LONG_DOUBLE
-		    long double long_double_value;
-#endif
-		} buf;
-		R_xlen_t s;
-		if(mode == 1) {
-		    for(i = 0, m = 0; i < n; i++) {
-			s = isRaw ? rawRead(buf.buf, size, 1, bytes, nbytes, &np)
-			    : int( con->read(buf.buf, size, 1, con));
-			if (s < 0) error("error reading from the connection");
-			if(s) m++; else break;
-			if(swap && size > 1) swapb(buf.buf, size);
+		/* Read blocks of elements of the given size, and convert
+		   each block as a whole. */
+		R_xlen_t nblock = READBIN_BYTES/size, s;
+		std::vector<char> buf(std::min<R_xlen_t>(n, nblock) * size);
+		for(i = 0, m = 0; i < n; i += s) {
+		    R_xlen_t k = std::min(nblock, n - i);
+		    s = isRaw ? rawRead(buf.data(), size, k, bytes, nbytes, &np)
+			: R_xlen_t( con->read(buf.data(), size, k, con));
+		    if (s < 0) error("error reading from the connection");
+		    if(swap && size > 1) swapBlock(buf.data(), s, size);
+		    if(mode == 1) {
+			int *out = INTEGER(ans) + i;
 			switch(size) {
 			case sizeof(signed char):
 			    if(signd)
-				INTEGER(ans)[i] = buf.signed_char_value;
+				convertBlock<signed char>(out, buf.data(), s);
 			    else
-				INTEGER(ans)[i] = buf.unsigned_char_value;
+				convertBlock<unsigned char>(out, buf.data(), s);
 			    break;
 			case sizeof(short):
 			    if(signd)
-				INTEGER(ans)[i] = buf.short_value;
+				convertBlock<short>(out, buf.data(), s);
 			    else
-				INTEGER(ans)[i] = buf.unsigned_short_value;
+				convertBlock<unsigned short>(out, buf.data(), s);
 			    break;
 #if SIZEOF_LONG == 8
 			case sizeof(long):
-			    INTEGER(ans)[i] = buf.long_value;
+			    convertBlock<long>(out, buf.data(), s);
 			    break;
 #elif SIZEOF_LONG_LONG == 8
 			case sizeof(_lli_t):
-                            INTEGER(ans)[i] = buf.lli_t_value;
+			    convertBlock<_lli_t>(out, buf.data(), s);
 			    break;
 #endif
 			default:
 			    error(_("size %d is unknown on this machine"), size);
 			}
-		    }
-		} else if (mode == 2) {
-		    for(i = 0, m = 0; i < n; i++) {
-			s = isRaw ? rawRead(buf.buf, size, 1, bytes, nbytes, &np)
-			    : int( con->read(buf.buf, size, 1, con));
-			if (s < 0) error("error reading from the connection");
-			if(s) m++; else break;
-			if(swap && size > 1) swapb(buf.buf, size);
+		    } else if (mode == 2) {
+			double *out = REAL(ans) + i;
 			switch(size) {
 			case sizeof(float):
-			    REAL(ans)[i] = buf.float_value;
+			    convertBlock<float>(out, buf.data(), s);
 			    break;
 #if HAVE_LONG_DOUBLE && (SIZEOF_LONG_DOUBLE > SIZEOF_DOUBLE)
 			case sizeof(long double):
-			    REAL(ans)[i] = double(buf.long_double_value);
+			    convertBlock<long double>(out, buf.data(), s);
 			    break;
 #endif
 			default:
@@ -4040,6 +4587,8 @@ SEXP attribute_hidden do_readbin(/*const*/ rho::Expression* call, const rho::Bui
 				  size);
 			}
 		    }
+		    m += s;
+		    if(s < k) break;
 		}
 	    }
 	}
@@ -4196,114 +4745,142 @@ SEXP attribute_hidden do_writebin(/*const*/ rho::Expression* call, const rho::Bu
 	    default:
 		UNIMPLEMENTED_TYPE("writeBin", object);
 	    }
-	    buf = RHO_S_CAST(char*, R_chk_calloc(len, size));
-	    switch(TYPEOF(object)) {
-	    case LGLSXP:
-	    case INTSXP:
-		switch (size) {
-		case sizeof(int):
-		    memcpy(buf, INTEGER(object), size * len);
+	    /* If the layout in memory is that wanted, the vector is
+	       written as it is. */
+	    const void *direct = nullptr;
+	    if(!swap || size == 1)
+		switch(TYPEOF(object)) {
+		case LGLSXP:
+		case INTSXP:
+		    if(size == sizeof(int)) direct = INTEGER(object);
+		    break;
+		case REALSXP:
+		    if(size == sizeof(double)) direct = REAL(object);
+		    break;
+		case CPLXSXP:
+		    direct = COMPLEX(object);
 		    break;
+		case RAWSXP:
+		    direct = RAW(object);
+		    break;
+		default:  // -Wswitch
+		    break;
+		}
+	    if(direct && isRaw && TYPEOF(object) == RAWSXP
+	       && ATTRIB(object) == R_NilValue) {
+		PROTECT(ans = object);
+	    } else if(direct && isRaw) {
+		PROTECT(ans = allocVector(RAWSXP, size*len));
+		memcpy(RAW(ans), direct, size*len);
+	    } else if(direct) {
+		size_t nwrite = con->write(direct, size, len, con);
+		if(RHO_S_CAST(int, nwrite) < len) warning(_("problem writing to connection"));
+	    } else {
+		buf = RHO_S_CAST(char*, R_chk_calloc(len, size));
+		switch(TYPEOF(object)) {
+		case LGLSXP:
+		case INTSXP:
+		    switch (size) {
+		    case sizeof(int):
+			memcpy(buf, INTEGER(object), size * len);
+			break;
 #if SIZEOF_LONG == 8
-		case sizeof(long):
-		    {
-			long l1;
-			for (i = 0, j = 0; i < len; i++, j += size) {
-			    l1 = long( INTEGER(object)[i]);
-			    memcpy(buf + j, &l1, size);
+		    case sizeof(long):
+			{
+			    long l1;
+			    for (i = 0, j = 0; i < len; i++, j += size) {
+				l1 = long( INTEGER(object)[i]);
+				memcpy(buf + j, &l1, size);
+			    }
+			    break;
 			}
-			break;
-		    }
 #elif SIZEOF_LONG_LONG == 8
-		case sizeof(_lli_t):
-		    {
-			_lli_t ll1;
-			for (i = 0, j = 0; i < len; i++, j += size) {
-			    ll1 = _lli_t( INTEGER(object)[i]);
-			    memcpy(buf + j, &ll1, size);
+		    case sizeof(_lli_t):
+			{
+			    _lli_t ll1;
+			    for (i = 0, j = 0; i < len; i++, j += size) {
+				ll1 = _lli_t( INTEGER(object)[i]);
+				memcpy(buf + j, &ll1, size);
+			    }
+			    break;
 			}
-			break;
-		    }
 #endif
-		case 2:
-		    {
-			short s1;
-			for (i = 0, j = 0; i < len; i++, j += size) {
-			    s1 = short( INTEGER(object)[i]);
-			    memcpy(buf + j, &s1, size);
+		    case 2:
+			{
+			    short s1;
+			    for (i = 0, j = 0; i < len; i++, j += size) {
+				s1 = short( INTEGER(object)[i]);
+				memcpy(buf + j, &s1, size);
+			    }
+			    break;
 			}
+		    case 1:
+			for (i = 0; i < len; i++)
+			    buf[i] = static_cast<signed char>( INTEGER(object)[i]);
 			break;
+		    default:
+			error(_("size %d is unknown on this machine"), size);
 		    }
-		case 1:
-		    for (i = 0; i < len; i++)
-			buf[i] = static_cast<signed char>( INTEGER(object)[i]);
-		    break;
-		default:
-		    error(_("size %d is unknown on this machine"), size);
-		}
-		break;
-	    case REALSXP:
-		switch (size) {
-		case sizeof(double):
-		    memcpy(buf, REAL(object), size * len);
 		    break;
-		case sizeof(float):
-		    {
-			float f1;
-			for (i = 0, j = 0; i < len; i++, j += size) {
-			    f1 = float( REAL(object)[i]);
-			    memcpy(buf+j, &f1, size);
-			}
+		case REALSXP:
+		    switch (size) {
+		    case sizeof(double):
+			memcpy(buf, REAL(object), size * len);
 			break;
-		    }
+		    case sizeof(float):
+			{
+			    float f1;
+			    for (i = 0, j = 0; i < len; i++, j += size) {
+				f1 = float( REAL(object)[i]);
+				memcpy(buf+j, &f1, size);
+			    }
+			    break;
+			}
 #if HAVE_LONG_DOUBLE && (SIZEOF_LONG_DOUBLE > SIZEOF_DOUBLE)
-		case sizeof(long double):
-		    {
-			/* some systems have problems with memcpy from
-			   the address of an automatic long double,
-			   e.g. ix86/x86_64 Linux with gcc4 */
-			static long double ld1;
-			for (i = 0, j = 0; i < len; i++, j += size) {
-			    ld1 = static_cast<long double>( REAL(object)[i]);
-			    memcpy(buf+j, &ld1, size);
+		    case sizeof(long double):
+			{
+			    /* some systems have problems with memcpy from
+			       the address of an automatic long double,
+			       e.g. ix86/x86_64 Linux with gcc4 */
+			    static long double ld1;
+			    for (i = 0, j = 0; i < len; i++, j += size) {
+				ld1 = static_cast<long double>( REAL(object)[i]);
+				memcpy(buf+j, &ld1, size);
+			    }
+			    break;
 			}
-			break;
-		    }
 #endif
-		default:
-		    error(_("size %d is unknown on this machine"), size);
+		    default:
+			error(_("size %d is unknown on this machine"), size);
+		    }
+		    break;
+		case CPLXSXP:
+		    memcpy(buf, COMPLEX(object), size * len);
+		    break;
+		case RAWSXP:
+		    memcpy(buf, RAW(object), len); /* size = 1 */
+		    break;
+		default:  // -Wswitch
+		    break;
 		}
-		break;
-	    case CPLXSXP:
-		memcpy(buf, COMPLEX(object), size * len);
-		break;
-	    case RAWSXP:
-		memcpy(buf, RAW(object), len); /* size = 1 */
-		break;
-	    default:  // -Wswitch
-		break;
-	    }
 
-	    if(swap && size > 1) {
-		if (TYPEOF(object) == CPLXSXP)
-		    for(i = 0; i < len; i++) {
-			int sz = size/2;
-			swapb(buf+sz*2*i, sz);
-			swapb(buf+sz*(2*i+1), sz);
-		    }
-		else
-		    for(i = 0; i < len; i++) swapb(buf+size*i, size);
-	    }
+		if(swap && size > 1) {
+		    if (TYPEOF(object) == CPLXSXP)
+			swapBlock(buf, 2*R_xlen_t(len), size/2);
+		    else
+			swapBlock(buf, len, size);
+		}
 
-	    /* write it now */
-	    if(isRaw) { /* We checked size*len < 2^31-1 above */
-		PROTECT(ans = allocVector(RAWSXP, size*len));
-		memcpy(RAW(ans), buf, size*len);
-	    } else {
-		size_t nwrite = con->write(buf, size, len, con);
-		if(RHO_S_CAST(int, nwrite) < len) warning(_("problem writing to connection"));
+		/* write it now */
+		if(isRaw) { /* We checked size*len < 2^31-1 above */
+		    PROTECT(ans = allocVector(RAWSXP, size*len));
+		    memcpy(RAW(ans), buf, size*len);
+		} else {
+		    size_t nwrite = con->write(buf, size, len, con);
+		    if(RHO_S_CAST(int, nwrite) < len) warning(_("problem writing to connection"));
+		}
+		Free(buf);
 	    }
-	    Free(buf);
 	}
     } catch (...) {
 	if (!wasopen && con->isopen)
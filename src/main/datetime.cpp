@@ -118,6 +118,7 @@ extern char *tzname[2];
 #include <Defn.h>
 #include <Internal.h>
 
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -135,6 +136,18 @@ namespace {
     }
 
     inline int days_in_year(int year) {return isleap(year) ? 366 : 365;}
+
+    inline int floor_div(int a, int b)
+    {
+	return a >= 0 ? a/b : -((b - 1 - a)/b);
+    }
+
+    // Leap years before year y, counted from year 0.
+    inline int leaps_before(int y)
+    {
+	--y;
+	return floor_div(y, 4) - floor_div(y, 100) + floor_div(y, 400);
+    }
 }
 
 /*
@@ -231,7 +244,7 @@ static int validate_tm (stm *tm)
 static double mktime00 (stm *tm)
 {
     int day = 0;
-    int year, year0;
+    int year0;
     double excess = 0.0;
 
     day = tm->tm_mday - 1;
@@ -249,13 +262,7 @@ static double mktime00 (stm *tm)
     if (tm->tm_mon > 1 && isleap(year0)) day++;
     tm->tm_yday = day;
 
-    if (year0 > 1970) {
-	for (year = 1970; year < year0; year++)
-	    day += days_in_year(year);
-    } else if (year0 < 1970) {
-	for (year = 1969; year >= year0; year--)
-	    day -= days_in_year(year);
-    }
+    day += 365 * (year0 - 1970) + leaps_before(year0) - leaps_before(1970);
 
     /* weekday: Epoch day was a Thursday */
     if ((tm->tm_wday = (day + 4) % 7) < 0) tm->tm_wday += 7;
@@ -659,6 +666,250 @@ static void glibc_fix(stm *tm, int *invalid)
 }
 
 
+/* Conversions of many local times are cached over each call.  From
+   1970 on, the offset from UTC changes only at a whole minute, and
+   mostly at a whole hour, so times that fall in the same minute as
+   the one before are converted without consulting the time zone
+   again. */
+
+namespace {
+    struct MktimeCache {
+	bool valid = false;
+	int key[6];
+	stm tm;		// As normalized by mktime0, with tm_sec = 0.
+	double t;
+    };
+}
+
+/* mktime0(tm, 1), for a series of times */
+static double mktime_local(stm *tm, MktimeCache *cache)
+{
+    if (tm->tm_year < 70 || tm->tm_sec < 0 || tm->tm_sec > 59)
+	return mktime0(tm, 1);
+    int key[6] = {tm->tm_year, tm->tm_mon, tm->tm_mday, tm->tm_hour,
+		  tm->tm_min, tm->tm_isdst};
+    if (!cache->valid || memcmp(key, cache->key, sizeof key)) {
+	stm tm0 = *tm;
+	tm0.tm_sec = 0;
+	errno = 0;
+	double t = mktime0(&tm0, 1);
+	cache->valid = (t != -1. && errno == 0);
+	if (!cache->valid)
+	    return mktime0(tm, 1);
+	memcpy(cache->key, key, sizeof key);
+	cache->tm = tm0;
+	cache->t = t;
+    }
+    int sec = tm->tm_sec;
+    *tm = cache->tm;
+    tm->tm_sec = sec;
+    return cache->t + sec;
+}
+
+#if defined(HAVE_TM_GMTOFF) \
+    && (defined(USE_INTERNAL_MKTIME) || defined(HAVE_POSIX_LEAPSECONDS))
+# define CACHE_UTC_OFFSET 1
+#endif
+
+namespace {
+    // The hour containing the last time converted, and whether the
+    // offset from UTC is known to be constant over it.
+    struct OffsetCache {
+	double start = -1;
+	bool probed = false;
+	bool constant = false;
+	long gmtoff;
+	int isdst;
+    };
+}
+
+/* localtime0(tp, 1, ltm), for a series of times.  When a time falls
+   in the same hour as the one before, the offset from UTC is looked
+   up at both ends of the hour, once: if it is the same, times within
+   the hour are converted as UTC times shifted by the offset.  Times
+   in a new hour are converted directly, so that series which rarely
+   stay within an hour pay no more than before. */
+static stm *localtime_local(const double *tp, stm *ltm, OffsetCache *cache)
+{
+#ifdef CACHE_UTC_OFFSET
+    double d = *tp;
+    if (d < 0.0 || d >= 2147483647.0)
+	return localtime0(tp, 1, ltm);
+    double start = floor(d/3600.0) * 3600.0, end = start + 3599.0;
+    if (start != cache->start) {
+	cache->start = start;
+	cache->probed = cache->constant = false;
+	return localtime0(tp, 1, ltm);
+    }
+    if (!cache->probed) {
+	cache->probed = true;
+	stm *p = localtime0(&start, 1, ltm);
+	if (p) {
+	    long gmtoff = p->tm_gmtoff;
+	    int isdst = p->tm_isdst;
+	    p = localtime0(&end, 1, ltm);
+	    if (p && p->tm_gmtoff == gmtoff && p->tm_isdst == isdst) {
+		cache->constant = true;
+		cache->gmtoff = gmtoff;
+		cache->isdst = isdst;
+	    }
+	}
+    }
+    if (cache->constant) {
+	double u = d + cache->gmtoff;
+	stm *p = localtime0(&u, 0, ltm);
+	if (p) {
+	    p->tm_isdst = cache->isdst;
+	    p->tm_gmtoff = cache->gmtoff;
+	}
+	return p;
+    }
+#endif
+    return localtime0(tp, 1, ltm);
+}
+
+
+/* Formats for strptime() and format.POSIXlt() made only of %Y, %m,
+   %d, %H, %M, %S (and %F and %T, which stand for them), %OS, %%,
+   white space and other printable ASCII characters.  These cover the
+   ISO 8601 layouts, and are handled without R_strptime() and
+   strftime().  Returns the format with %F and %T expanded, or "" if
+   the format is not of this kind. */
+static std::string fixedTimeFormat(const char *fmt)
+{
+    std::string res;
+    for (const char *p = fmt; *p; p++) {
+	if (*p < ' ' || *p > '~') {
+	    if (!isspace((unsigned char)*p))
+		return "";
+	    res += *p;
+	} else if (*p != '%')
+	    res += *p;
+	else if (p[1] == 'F') {
+	    res += "%Y-%m-%d";
+	    p++;
+	} else if (p[1] == 'T') {
+	    res += "%H:%M:%S";
+	    p++;
+	} else if (p[1] == 'O' && p[2] == 'S') {
+	    res += "%OS";
+	    p += 2;
+	} else if (p[1] && strchr("YmdHMS%", p[1])) {
+	    res += p[0];
+	    res += p[1];
+	    p++;
+	} else
+	    return "";
+    }
+    // Bound the length of the result of strftimeFixed().
+    return (res.size() < 100) ? res : "";
+}
+
+/* Parse s, which is ASCII, by a format from fixedTimeFormat(): every
+   number must have all its digits, and s must not go on beyond the
+   format.  Returns false if R_strptime() is needed instead, which for
+   input accepted here gives the same result. */
+static bool strptimeFixed(const char *s, const char *fmt, stm *tm,
+			  double *psecs)
+{
+    for (; *fmt; fmt++) {
+	if (isspace((unsigned char)*fmt)) {
+	    while (isspace((unsigned char)*s)) s++;
+	    continue;
+	}
+	if (*fmt != '%') {
+	    if (*s++ != *fmt) return false;
+	    continue;
+	}
+	char conv = *++fmt;
+	if (conv == '%') {
+	    if (*s++ != '%') return false;
+	    continue;
+	}
+	if (conv == 'O') {
+	    // %OS, as in R_strptime
+	    fmt++;
+	    char *end;
+	    double sval = strtod(s, &end);
+	    if (sval >= 0.0 && sval <= 61.0) {
+		tm->tm_sec = int(sval);
+		*psecs = sval;
+	    }
+	    s = end;
+	    continue;
+	}
+	int ndigits = (conv == 'Y') ? 4 : 2, val = 0;
+	for (int k = 0; k < ndigits; k++, s++) {
+	    if (*s < '0' || *s > '9') return false;
+	    val = 10 * val + (*s - '0');
+	}
+	switch (conv) {
+	case 'Y':
+	    tm->tm_year = val - 1900;
+	    break;
+	case 'm':
+	    if (val < 1 || val > 12) return false;
+	    tm->tm_mon = val - 1;
+	    break;
+	case 'd':
+	    if (val < 1 || val > 31) return false;
+	    tm->tm_mday = val;
+	    break;
+	case 'H':
+	    if (val > 24) return false;
+	    tm->tm_hour = val;
+	    break;
+	case 'M':
+	    if (val > 59) return false;
+	    tm->tm_min = val;
+	    break;
+	case 'S':
+	    if (val > 61) return false;
+	    tm->tm_sec = val;
+	    break;
+	}
+    }
+    return *s == '\0';
+}
+
+/* Format a valid tm by a format from fixedTimeFormat() without %OS,
+   into buff.  Returns false if strftime() is needed instead, for years
+   outside 1000-9999. */
+static bool strftimeFixed(char *buff, const char *fmt, const stm *tm)
+{
+    int year = tm->tm_year + 1900;
+    if (year < 1000 || year > 9999)
+	return false;
+    char *q = buff;
+    for (; *fmt; fmt++) {
+	if (*fmt != '%') {
+	    *q++ = *fmt;
+	    continue;
+	}
+	int val;
+	switch (*++fmt) {
+	case 'Y':
+	    *q++ = char('0' + year / 1000);
+	    *q++ = char('0' + year / 100 % 10);
+	    val = year % 100;
+	    break;
+	case 'm': val = tm->tm_mon + 1; break;
+	case 'd': val = tm->tm_mday; break;
+	case 'H': val = tm->tm_hour; break;
+	case 'M': val = tm->tm_min; break;
+	case 'S': val = tm->tm_sec; break;
+	default:
+	    *q++ = '%';
+	    continue;
+	}
+	*q++ = char('0' + val / 10);
+	*q++ = char('0' + val % 10);
+    }
+    *q = '\0';
+    return true;
+}
+
+
 static const char ltnames [][7] =
 { "sec", "min", "hour", "mday", "mon", "year", "wday", "yday", "isdst",
   "zone",  "gmtoff"};
@@ -748,11 +999,13 @@ SEXP attribute_hidden do_asPOSIXlt(/*const*/ rho::Expression* call, const rho::B
     for(int i = 0; i < nans; i++)
 	SET_STRING_ELT(ansnames, i, mkChar(ltnames[i]));
 
+    OffsetCache offsets;
     for(R_xlen_t i = 0; i < n; i++) {
 	stm dummy, *ptm = &dummy;
 	double d = REAL(x)[i];
 	if(R_FINITE(d)) {
-	    ptm = localtime0(&d, 1 - isgmt, &dummy);
+	    ptm = isgmt ? localtime0(&d, 0, &dummy)
+		: localtime_local(&d, &dummy, &offsets);
 	    /* in theory localtime/gmtime always return a valid
 	       struct tm pointer, but Windows uses NULL for error
 	       conditions (like negative times). */
@@ -838,6 +1091,7 @@ SEXP attribute_hidden do_asPOSIXct(/*const*/ rho::Expression* call, const rho::B
     SET_VECTOR_ELT(x, 8, coerceVector(VECTOR_ELT(x, 8), INTSXP));
 
     PROTECT(ans = allocVector(REALSXP, n));
+    MktimeCache cache;
     for(R_xlen_t i = 0; i < n; i++) {
 	double secs = REAL(VECTOR_ELT(x, 0))[i%nlen[0]], fsecs = floor(secs);
 	// avoid (int) NAN
@@ -855,7 +1109,7 @@ SEXP attribute_hidden do_asPOSIXct(/*const*/ rho::Expression* call, const rho::B
 	    REAL(ans)[i] = NA_REAL;
 	else {
 	    errno = 0;
-	    tmp = mktime0(&tm, 1 - isgmt);
+	    tmp = isgmt ? mktime0(&tm, 0) : mktime_local(&tm, &cache);
 #ifdef MKTIME_SETS_ERRNO
 	    REAL(ans)[i] = errno ? NA_REAL : tmp + (secs - fsecs);
 #else
@@ -895,12 +1149,21 @@ SEXP attribute_hidden do_formatPOSIXlt(/*const*/ rho::Expression* call, const rh
     SEXP tz = getAttrib(x, install("tzone"));
 
     const char *tz1;
+    /* Translate the formats once, and find those that can be written
+       without strftime() */
+    std::vector<std::string> formats(m), fixed(m);
+    for(R_xlen_t i = 0; i < m; i++) {
+	formats[i] = translateChar(STRING_ELT(sformat, i));
+	fixed[i] = fixedTimeFormat(formats[i].c_str());
+	if (fixed[i].find("%OS") != std::string::npos)
+	    fixed[i].clear();
+    }
     if (!isNull(tz) && strlen(tz1 = CHAR(STRING_ELT(tz, 0)))) {
 	/* If the format includes %Z or %z
 	   we need to try to set TZ accordingly */
 	int needTZ = 0;
 	for(R_xlen_t i = 0; i < m; i++) {
-	    const char *p = translateChar(STRING_ELT(sformat, i));
+	    const char *p = formats[i].c_str();
 	    if (strstr(p, "%Z") || strstr(p, "%z")) {needTZ = 1; break;}
 	}
 	if(needTZ) settz = set_tz(tz1, oldtz);
@@ -928,6 +1191,8 @@ SEXP attribute_hidden do_formatPOSIXlt(/*const*/ rho::Expression* call, const rh
     R_xlen_t N = (n > 0) ? ((m > n) ? m : n) : 0;
     SEXP ans = PROTECT(allocVector(STRSXP, N));
     char tm_zone[20];
+    vector<char> buf2v;
+    int digits_secs = -1;
 #ifdef HAVE_TM_GMTOFF
     Rboolean have_zone = Rboolean(
 	LENGTH(x) >= 11 && XLENGTH(VECTOR_ELT(x, 9)) == n &&
@@ -971,58 +1236,65 @@ SEXP attribute_hidden do_formatPOSIXlt(/*const*/ rho::Expression* call, const rh
 	} else if(validate_tm(&tm) < 0) {
 	    SET_STRING_ELT(ans, i, NA_STRING);
 	} else {
-	    const char *q = translateChar(STRING_ELT(sformat, i%m));
-	    int nn = (int) strlen(q) + 50;
-	    vector<char> buf2v(nn);
-            char* buf2 = &buf2v[0];
-	    const char *p;
+	    if(fixed[i%m].empty()
+	       || !strftimeFixed(buff, fixed[i%m].c_str(), &tm)) {
+		const char *q = formats[i%m].c_str();
+		int nn = (int) strlen(q) + 50;
+		buf2v.resize(nn);
+		char* buf2 = &buf2v[0];
+		const char *p;
 #ifdef OLD_Win32
-	    /* We want to override Windows' TZ names */
-	    p = strstr(q, "%Z");
-	    if (p) {
-		memset(buf2, 0, nn);
-		strncpy(buf2, q, p - q);
-		if(have_zone)
-		    strcat(buf2, tm_zone);
-		else
-		    strcat(buf2, tm.tm_isdst > 0 ? R_tzname[1] : R_tzname[0]);
-		strcat(buf2, p+2);
-	    } else
+		/* We want to override Windows' TZ names */
+		p = strstr(q, "%Z");
+		if (p) {
+		    memset(buf2, 0, nn);
+		    strncpy(buf2, q, p - q);
+		    if(have_zone)
+			strcat(buf2, tm_zone);
+		    else
+			strcat(buf2, tm.tm_isdst > 0 ? R_tzname[1] : R_tzname[0]);
+		    strcat(buf2, p+2);
+		} else
 #endif
-		strcpy(buf2, q);
-
-	    p = strstr(q, "%OS");
-	    if(p) {
-		/* FIXME some of this should be outside the loop */
-		int ns, nused = 4;
-		char *p2 = strstr(buf2, "%OS");
-		*p2 = '\0';
-		ns = *(p+3) - '0';
-		if(ns < 0 || ns > 9) { /* not a digit */
-		    ns = asInteger(GetOption1(install("digits.secs")));
-		    if(ns == NA_INTEGER) ns = 0;
-		    nused = 3;
-		}
-		if(ns > 6) ns = 6;
-		if(ns > 0) {
-		    /* truncate to avoid nuisances such as PR#14579 */
-		    double s = secs, t = Rexp10((double) ns);
-		    s = ((int) (s*t))/t;
-		    sprintf(p2, "%0*.*f", ns+3, ns, s);
-		    strcat(buf2, p+nused);
-		} else {
-		    strcat(p2, "%S");
-		    strcat(buf2, p+nused);
+		    strcpy(buf2, q);
+
+		p = strstr(q, "%OS");
+		if(p) {
+		    /* FIXME some of this should be outside the loop */
+		    int ns, nused = 4;
+		    char *p2 = strstr(buf2, "%OS");
+		    *p2 = '\0';
+		    ns = *(p+3) - '0';
+		    if(ns < 0 || ns > 9) { /* not a digit */
+			if(digits_secs < 0) {
+			    digits_secs =
+				asInteger(GetOption1(install("digits.secs")));
+			    if(digits_secs == NA_INTEGER) digits_secs = 0;
+			}
+			ns = digits_secs;
+			nused = 3;
+		    }
+		    if(ns > 6) ns = 6;
+		    if(ns > 0) {
+			/* truncate to avoid nuisances such as PR#14579 */
+			double s = secs, t = Rexp10((double) ns);
+			s = ((int) (s*t))/t;
+			sprintf(p2, "%0*.*f", ns+3, ns, s);
+			strcat(buf2, p+nused);
+		    } else {
+			strcat(p2, "%S");
+			strcat(buf2, p+nused);
+		    }
 		}
-	    }
-	    // The overflow behaviour is not determined by C99.
-	    // We assume truncation, and ensure termination.
+		// The overflow behaviour is not determined by C99.
+		// We assume truncation, and ensure termination.
 #ifdef USE_INTERNAL_MKTIME
-	    R_strftime(buff, 256, buf2, &tm);
+		R_strftime(buff, 256, buf2, &tm);
 #else
-	    strftime(buff, 256, buf2, &tm);
+		strftime(buff, 256, buf2, &tm);
 #endif
-	    buff[256] = '\0';
+		buff[256] = '\0';
+	    }
 	    // Now assume tzone abbreviated name is < 40 bytes,
 	    // but they are currently 3 or 4 bytes.
 	    if(UseTZ) {
@@ -1116,6 +1388,14 @@ SEXP attribute_hidden do_strptime(/*const*/ rho::Expression* call, const rho::Bu
     for(int i = 0; i < nans; i++)
 	SET_STRING_ELT(ansnames, i, mkChar(ltnames[i]));
 
+    /* Translate the formats once, and find those that can be parsed
+       without R_strptime() */
+    std::vector<std::string> formats(m), fixed(m);
+    for(R_xlen_t j = 0; j < m && j < N; j++) {
+	formats[j] = translateChar(STRING_ELT(sformat, j));
+	fixed[j] = fixedTimeFormat(formats[j].c_str());
+    }
+    MktimeCache cache;
 
     for(R_xlen_t i = 0; i < N; i++) {
 	/* for glibc's sake. That only sets some unspecified fields,
@@ -1129,10 +1409,16 @@ SEXP attribute_hidden do_strptime(/*const*/ rho::Expression* call, const rho::Bu
 	tm.tm_isdst = -1;
 #endif
 	offset = NA_INTEGER;
-	invalid = STRING_ELT(x, i%n) == NA_STRING ||
-	    !R_strptime(translateChar(STRING_ELT(x, i%n)),
-			translateChar(STRING_ELT(sformat, i%m)),
-			&tm, &psecs, &offset);
+	SEXP xi = STRING_ELT(x, i%n);
+	const std::string &fixed_i = fixed[i%m];
+	if(xi == NA_STRING)
+	    invalid = 1;
+	else if(!fixed_i.empty() && IS_ASCII(xi)
+		&& strptimeFixed(CHAR(xi), fixed_i.c_str(), &tm, &psecs))
+	    invalid = 0;
+	else
+	    invalid = !R_strptime(translateChar(xi), formats[i%m].c_str(),
+				  &tm, &psecs, &offset);
 	if(!invalid) {
 	    /* Solaris sets missing fields to 0 */
 	    if(tm.tm_mday == 0) tm.tm_mday = NA_INTEGER;
@@ -1158,7 +1444,8 @@ SEXP attribute_hidden do_strptime(/*const*/ rho::Expression* call, const rho::Bu
 		/* we do want to set wday, yday, isdst, but not to
 		   adjust structure at DST boundaries */
 		memcpy(&tm2, &tm, sizeof(stm));
-		mktime0(&tm2, 1-isgmt); /* set wday, yday, isdst */
+		/* set wday, yday, isdst */
+		if(isgmt) mktime0(&tm2, 0); else mktime_local(&tm2, &cache);
 		tm.tm_wday = tm2.tm_wday;
 		tm.tm_yday = tm2.tm_yday;
 		tm.tm_isdst = isgmt ? 0: tm2.tm_isdst;
@@ -53,15 +53,19 @@
 #include "rho/ClosureContext.hpp"
 #include "rho/DottedArgs.hpp"
 #include "rho/ExpressionVector.hpp"
+#include "rho/GCManager.hpp"
 #include "rho/GCStackFrameBoundary.hpp"
+#include "rho/IntVector.hpp"
 #include "rho/ListFrame.hpp"
 #include "rho/LoopBailout.hpp"
 #include "rho/LoopException.hpp"
 #include "rho/Promise.hpp"
 #include "rho/ProvenanceTracker.hpp"
+#include "rho/RealVector.hpp"
 #include "rho/ReturnBailout.hpp"
 #include "rho/ReturnException.hpp"
 #include "rho/S3Launcher.hpp"
+#include "rho/StringVector.hpp"
 
 using namespace std;
 using namespace rho;
@@ -109,6 +113,23 @@ using namespace rho;
 
    L. T.  */
 
+/* rho: the SIGPROF handler only reads objects, and neither allocates
+   nor looks anything up in an Environment.  It walks the chain of
+   Evaluator::Context objects and records each sample in a ring
+   buffer, identifying functions by pointers to Symbol objects, which
+   are never garbage collected.  For line profiling, the file of each
+   srcref made current is looked up on the main thread, by
+   noteSrcref(), and the handler only matches srcfile pointers.  A background
+   thread drains the buffer, formatting the samples into the Rprof.out
+   file, and aggregating them for the optional folded-stack (as read
+   by flamegraph.pl) and pprof outputs, which are written when
+   profiling stops.  The ring buffer has a single producer and a
+   single consumer, and needs no locks; if the drain thread falls
+   behind, samples are dropped and counted.  Samples taken during
+   garbage collection are marked "<GC>" if GC profiling is on, and
+   those taken while the innermost closure runs JIT-compiled code are
+   marked "<JIT>". */
+
 #ifdef Win32
 # define WIN32_LEAN_AND_MEAN 1
 # include <windows.h>		/* for CreateEvent, SetEvent */
@@ -120,7 +141,18 @@ using namespace rho;
 # include <signal.h>
 #endif /* not Win32 */
 
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pprof.h"
+
 static FILE *R_ProfileOutfile = nullptr;
+static FILE *R_ProfileFoldedfile = nullptr;	   /* optional outputs */
+static FILE *R_ProfilePprofFile = nullptr;
 static int R_Mem_Profiling=0;
 extern void get_current_mem(unsigned long *,unsigned long *,unsigned long *); /* in memory.c */
 extern unsigned long get_duplicate_counter(void);  /* in duplicate.c */
@@ -131,15 +163,27 @@ static char **R_Srcfiles;			   /* an array of pointers into the filename buffer
 static size_t R_Srcfile_bufcount;                  /* how big is the array above? */
 static GCRoot<> R_Srcfiles_buffer = nullptr;              /* a big RAWSXP to use as a buffer for filenames and pointers to them */
 static int R_Profiling_Error;		   /* record errors here */
+static int R_Profile_Interval;		   /* in microseconds */
+static Symbol* R_FilenameSymbol;
+
+/* Srcfile environments seen by line profiling, with their file
+   numbers, as noted by noteSrcref() on the main thread.  The signal
+   handler reads the first R_ProfSrcfileCount of them. */
+namespace {
+    struct ProfSrcfile {
+	GCRoot<const RObject> env;
+	int fnum;
+    };
+}
+static ProfSrcfile* R_ProfSrcfiles = nullptr;
+static int R_ProfSrcfileMax;
+static std::atomic<int> R_ProfSrcfileCount(0);
 
 #ifdef Win32
 HANDLE MainThread;
 HANDLE ProfileEvent;
 #endif /* Win32 */
 
-/* Careful here!  These functions are called asynchronously, maybe in the middle of GC,
-   so don't do any allocations */
-
 /* This does a linear search through the previously recorded filenames.  If
    this one is new, we try to add it.  FIXME:  if there are eventually
    too many files for an efficient linear search, do hashing. */
@@ -170,37 +214,217 @@ static int getFilenum(const char* filename) {
     return fnum + 1;
 }
 
-/* These, together with sprintf/strcat, are not safe -- we should be
-   using snprintf and such and computing needed sizes, but these
-   settings are better than what we had. LT */
+/* The srcfile environment of srcref, or null. */
+static const RObject* srcrefFile(const RObject* srcref)
+{
+    if (!srcref || srcref->sexptype() != INTSXP
+	|| static_cast<const IntVector*>(srcref)->size() == 0)
+	return nullptr;
+    const RObject* srcfile = srcref->getAttribute(
+	static_cast<Symbol*>(R_SrcfileSymbol));
+    return (srcfile && srcfile->sexptype() == ENVSXP) ? srcfile : nullptr;
+}
 
-#define PROFBUFSIZ 10500
-#define PROFITEMMAX  500
-#define PROFLINEMAX (PROFBUFSIZ - PROFITEMMAX)
+/* Called on the main thread when srcref is made current during line
+   profiling, to give its srcfile a file number if it has none. */
+static void noteSrcref(const RObject* srcref)
+{
+    const RObject* srcfile = srcrefFile(srcref);
+    if (!srcfile)
+	return;
+    int n = R_ProfSrcfileCount.load(std::memory_order_relaxed);
+    for (int i = n - 1; i >= 0; i--)
+	if (R_ProfSrcfiles[i].env == srcfile)
+	    return;
+    if (n == R_ProfSrcfileMax) {
+	R_Profiling_Error = 1;
+	return;
+    }
+    int fnum = 0;
+    const Frame::Binding* binding
+	= static_cast<const Environment*>(srcfile)->frame()
+	->binding(R_FilenameSymbol);
+    const RObject* filename = binding ? binding->rawValue() : nullptr;
+    if (filename && filename->sexptype() == STRSXP) {
+	const StringVector* names = static_cast<const StringVector*>(filename);
+	if (names->size() > 0 && (*names)[0])
+	    fnum = getFilenum((*names)[0]->c_str());
+    }
+    R_ProfSrcfiles[n].env = srcfile;
+    R_ProfSrcfiles[n].fnum = fnum;
+    R_ProfSrcfileCount.store(n + 1, std::memory_order_release);
+}
 
-/* It would also be better to flush the buffer when it gets full,
-   even if the line isn't complete. But this isn't possible if we rely
-   on writing all line profiling files first.  With these sizes
-   hitting the limit is fairly unlikely, but if we do then the output
-   file is wrong. Maybe writing an overflow marker of some sort would
-   be better.  LT */
+/* Sets *fnum and *line to the position recorded in srcref, or to 0 if
+   there is none.  Called by the signal handler, so only reads
+   objects, and finds the file number among those noted. */
+static void srcrefPosition(const RObject* srcref, int* fnum, int* line)
+{
+    *fnum = *line = 0;
+    const RObject* srcfile = srcrefFile(srcref);
+    if (!srcfile)
+	return;
+    int n = R_ProfSrcfileCount.load(std::memory_order_acquire);
+    for (int i = n - 1; i >= 0; i--)
+	if (R_ProfSrcfiles[i].env == srcfile) {
+	    if ((*fnum = R_ProfSrcfiles[i].fnum))
+		*line = (*static_cast<const IntVector*>(srcref))[0];
+	    return;
+	}
+}
+
+namespace {
+    /* A function on a sampled stack, as recorded by the signal
+       handler.  The function is usually named by a symbol, or else
+       by a call to ::, :::, $ or [[, as in R. */
+    struct ProfFrame {
+	enum Kind : unsigned char {
+	    ANONYMOUS,
+	    NAMED,		/* name */
+	    QUALIFIED,		/* name op member, e.g. stats::median */
+	    INDEXED_SYMBOL,	/* name[[member]] */
+	    INDEXED_STRING,	/* name[["text"]] */
+	    INDEXED_NUMBER	/* name[[number]] */
+	};
+
+	Kind kind;
+	const Symbol* name;
+	const Symbol* op;
+	const Symbol* member;
+	union {
+	    char text[24];	/* truncated */
+	    double number;
+	};
+	int fnum, line;		/* for line profiling; 0 if unknown */
+    };
+
+    /* Deeper stacks lose their outermost frames. */
+    const int PROF_MAX_DEPTH = 128;
+    const size_t PROF_RING_SIZE = 256;
+    const int PROF_DRAIN_MILLIS = 10;
+
+    struct ProfSample {
+	unsigned long mem[4];	/* small, big, nodes, duplications */
+	bool gc, jit;
+	int nfiles;		/* R_Line_Profiling after the sample */
+	int fnum, line;		/* position of R_Srcref */
+	int depth;
+	ProfFrame frames[PROF_MAX_DEPTH];  /* innermost first */
+    };
+
+    ProfSample* R_ProfRing = nullptr;
+    std::atomic<size_t> R_ProfHead(0);	/* written by the signal handler */
+    std::atomic<size_t> R_ProfTail(0);	/* written by the drain thread */
+    std::atomic<bool> R_ProfStopping(false);
+    size_t R_ProfDropped = 0;
+    std::thread* R_ProfDrainThread = nullptr;
+
+    /* Stacks aggregated for the folded and pprof outputs, as
+       interned names, innermost first. */
+    PprofProfile* R_ProfStackNames = nullptr;
+    std::map<std::vector<uint64_t>, uint64_t>* R_ProfStacks = nullptr;
+}
 
-static void lineprof(char* buf, SEXP srcref)
+static const Symbol* asSymbol(const RObject* x)
 {
-    size_t len;
-    if (srcref && !Rf_isNull(srcref) && (len = strlen(buf)) < PROFLINEMAX) {
-	int fnum, line = Rf_asInteger(srcref);
-	SEXP srcfile = Rf_getAttrib(srcref, R_SrcfileSymbol);
-	const char *filename;
+    return (x && x->sexptype() == SYMSXP
+	    ? static_cast<const Symbol*>(x) : nullptr);
+}
 
-	if (!srcfile || TYPEOF(srcfile) != ENVSXP) return;
-	srcfile = Rf_findVar(Rf_install("filename"), srcfile);
-	if (TYPEOF(srcfile) != STRSXP || !length(srcfile)) return;
-	filename = CHAR(STRING_ELT(srcfile, 0));
+static void describeFunction(const RObject* fun, ProfFrame* frame)
+{
+    frame->kind = ProfFrame::ANONYMOUS;
+    if ((frame->name = asSymbol(fun))) {
+	frame->kind = ProfFrame::NAMED;
+	return;
+    }
+    if (!fun || fun->sexptype() != LANGSXP)
+	return;
+    const ConsCell* call = static_cast<const ConsCell*>(fun);
+    const PairList* args = call->tail();
+    if (!args || !args->tail()
+	|| !(frame->name = asSymbol(args->car())))
+	return;
+    const RObject* op = call->car();
+    const RObject* arg2 = args->tail()->car();
+    if (op == R_DoubleColonSymbol || op == R_TripleColonSymbol
+	|| op == R_DollarSymbol) {
+	/* Function accessed via ::, :::, or $. Both args must be
+	   symbols. It is possible to use strings with these
+	   functions, as in "base"::"list", but that's a very rare
+	   case so we won't bother handling it. */
+	if ((frame->member = asSymbol(arg2))) {
+	    frame->op = asSymbol(op);
+	    frame->kind = ProfFrame::QUALIFIED;
+	}
+    } else if (op == R_Bracket2Symbol && arg2) {
+	/* Function accessed via [[. The first arg must be a symbol
+	   and the second can be a symbol, string, integer, or
+	   real. */
+	if (arg2->sexptype() == SYMSXP) {
+	    frame->member = static_cast<const Symbol*>(arg2);
+	    frame->kind = ProfFrame::INDEXED_SYMBOL;
+	} else if (arg2->sexptype() == STRSXP) {
+	    const StringVector* sv = static_cast<const StringVector*>(arg2);
+	    if (sv->size() == 0)
+		return;
+	    const char* text = (*sv)[0] ? (*sv)[0]->c_str() : "NA";
+	    size_t i = 0;
+	    for (; text[i] && i < sizeof(frame->text) - 1; ++i)
+		frame->text[i] = text[i];
+	    frame->text[i] = '\0';
+	    frame->kind = ProfFrame::INDEXED_STRING;
+	} else if (arg2->sexptype() == INTSXP) {
+	    const IntVector* iv = static_cast<const IntVector*>(arg2);
+	    if (iv->size() == 0)
+		return;
+	    frame->number = (*iv)[0];
+	    frame->kind = ProfFrame::INDEXED_NUMBER;
+	} else if (arg2->sexptype() == REALSXP) {
+	    const RealVector* rv = static_cast<const RealVector*>(arg2);
+	    if (rv->size() == 0)
+		return;
+	    frame->number = (*rv)[0];
+	    frame->kind = ProfFrame::INDEXED_NUMBER;
+	}
+    }
+}
 
-	if ((fnum = getFilenum(filename)))
-	    snprintf(buf+len, PROFBUFSIZ - len, "%d#%d ", fnum, line);
+static void recordSample(ProfSample* sample)
+{
+    sample->gc = GCManager::gcIsRunning();
+    if (R_Mem_Profiling) {
+	get_current_mem(&sample->mem[0], &sample->mem[1], &sample->mem[2]);
+	sample->mem[3] = get_duplicate_counter();
+	reset_duplicate_counter();
     }
+    if (R_Line_Profiling)
+	srcrefPosition(R_Srcref, &sample->fnum, &sample->line);
+
+    sample->depth = 0;
+    sample->jit = false;
+    bool in_closure = false;
+    for (Evaluator::Context* cptr = Evaluator::Context::innermost();
+	 cptr && sample->depth < PROF_MAX_DEPTH; cptr = cptr->nextOut()) {
+	Evaluator::Context::Type type = cptr->type();
+	if (type == Evaluator::Context::COMPILED && !in_closure)
+	    sample->jit = true;
+	if (type != Evaluator::Context::FUNCTION
+	    && type != Evaluator::Context::CLOSURE)
+	    continue;
+	in_closure = in_closure || type == Evaluator::Context::CLOSURE;
+	FunctionContext* fctxt = static_cast<FunctionContext*>(cptr);
+	ProfFrame* frame = &sample->frames[sample->depth++];
+	describeFunction(fctxt->call()->car(), frame);
+	frame->fnum = frame->line = 0;
+	if (R_Line_Profiling)
+	    srcrefPosition(fctxt->sourceLocation(), &frame->fnum, &frame->line);
+    }
+    /* The names of files numbered by noteSrcref() are complete once
+       it has published them through R_ProfSrcfileCount; the drain
+       thread sees them through R_ProfHead. */
+    R_ProfSrcfileCount.load(std::memory_order_acquire);
+    sample->nfiles = R_Line_Profiling;
 }
 
 /* FIXME: This should be done wih a proper configure test, also making
@@ -218,13 +442,6 @@ static pthread_t R_profiled_thread;
 
 static void doprof(int sig)  /* sig is ignored in Windows */
 {
-    char buf[PROFBUFSIZ];
-    unsigned long bigv, smallv, nodes;
-    size_t len;
-    int prevnum = R_Line_Profiling;
-
-    buf[0] = '\0';
-
 #ifdef Win32
     SuspendThread(MainThread);
 #elif defined(HAVE_PTHREAD)
@@ -234,116 +451,147 @@ static void doprof(int sig)  /* sig is ignored in Windows */
     }
 #endif /* Win32 */
 
-    if (R_Mem_Profiling){
-	    get_current_mem(&smallv, &bigv, &nodes);
-	    if((len = strlen(buf)) < PROFLINEMAX)
-		snprintf(buf+len, PROFBUFSIZ - len,
-			 ":%ld:%ld:%ld:%ld:", smallv, bigv,
-			 nodes, get_duplicate_counter());
-	    reset_duplicate_counter();
-    }
-
-// R_gc_running() not (yet) implemented in rho:
-#if 0
-    if (R_GC_Profiling && R_gc_running())
-	strcat(buf, "\"<GC>\" ");
-#endif
-
-    if (R_Line_Profiling)
-	lineprof(buf, R_Srcref);
-
-// rho FIXME: not yet adapted for rho:
-#if 0
-    for (Evaluator::Context* cptr = Evaluator::Context::innermost();
-	 cptr; cptr = cptr->nextOut()) {
-	if (TYPEOF(cptr->call) == LANGSXP) {
-	    SEXP fun = CAR(cptr->call);
-	    if(strlen(buf) < PROFLINEMAX) {
-		strcat(buf, "\"");
-
-		char itembuf[PROFITEMMAX];
-
-		if (TYPEOF(fun) == SYMSXP) {
-		    snprintf(itembuf, PROFITEMMAX-1, "%s", CHAR(PRINTNAME(fun)));
-
-		} else if ((CAR(fun) == R_DoubleColonSymbol ||
-			    CAR(fun) == R_TripleColonSymbol ||
-			    CAR(fun) == R_DollarSymbol) &&
-			   TYPEOF(CADR(fun)) == SYMSXP &&
-			   TYPEOF(CADDR(fun)) == SYMSXP) {
-		    /* Function accessed via ::, :::, or $. Both args must be
-		       symbols. It is possible to use strings with these
-		       functions, as in "base"::"list", but that's a very rare
-		       case so we won't bother handling it. */
-		    snprintf(itembuf, PROFITEMMAX-1, "%s%s%s",
-			     CHAR(PRINTNAME(CADR(fun))),
-			     CHAR(PRINTNAME(CAR(fun))),
-			     CHAR(PRINTNAME(CADDR(fun))));
-
-		} else if (CAR(fun) == R_Bracket2Symbol &&
-			   TYPEOF(CADR(fun)) == SYMSXP &&
-			   ((TYPEOF(CADDR(fun)) == SYMSXP ||
-			     TYPEOF(CADDR(fun)) == STRSXP ||
-			     TYPEOF(CADDR(fun)) == INTSXP ||
-			     TYPEOF(CADDR(fun)) == REALSXP) &&
-			    length(CADDR(fun)) > 0)) {
-		    /* Function accessed via [[. The first arg must be a symbol
-		       and the second can be a symbol, string, integer, or
-		       real. */
-		    SEXP arg1 = CADR(fun);
-		    SEXP arg2 = CADDR(fun);
-		    char arg2buf[PROFITEMMAX];
-
-		    if (TYPEOF(arg2) == SYMSXP) {
-			snprintf(arg2buf, PROFITEMMAX-1, "%s", CHAR(PRINTNAME(arg2)));
-
-		    } else if (TYPEOF(arg2) == STRSXP) {
-			snprintf(arg2buf, PROFITEMMAX-1, "\"%s\"", CHAR(STRING_ELT(arg2, 0)));
-
-		    } else if (TYPEOF(arg2) == INTSXP) {
-			snprintf(arg2buf, PROFITEMMAX-1, "%d", INTEGER(arg2)[0]);
+    size_t head = R_ProfHead.load(std::memory_order_relaxed);
+    if (head - R_ProfTail.load(std::memory_order_acquire) < PROF_RING_SIZE) {
+	recordSample(&R_ProfRing[head % PROF_RING_SIZE]);
+	R_ProfHead.store(head + 1, std::memory_order_release);
+    } else
+	R_ProfDropped++;
 
-		    } else if (TYPEOF(arg2) == REALSXP) {
-			snprintf(arg2buf, PROFITEMMAX-1, "%.0f", REAL(arg2)[0]);
-
-		    } else {
-			/* Shouldn't get here, but just in case. */
-			arg2buf[0] = '\0';
-		    }
+#ifdef Win32
+    ResumeThread(MainThread);
+#endif /* Win32 */
+}
 
-		    snprintf(itembuf, PROFITEMMAX-1, "%s[[%s]]",
-			     CHAR(PRINTNAME(arg1)),
-			     arg2buf);
+/* The remaining functions run on the drain thread, and must not touch
+   anything on the R heap except the names of Symbols. */
 
-		} else {
-		    sprintf(itembuf, "<Anonymous>");
-		}
-
-		strcat(buf, itembuf);
-		strcat(buf, "\" ");
-		if (R_Line_Profiling)
-		    lineprof(buf, cptr->srcref);
-	    }
-	}
+static std::string frameName(const ProfFrame& frame)
+{
+    if (frame.kind == ProfFrame::ANONYMOUS)
+	return "<Anonymous>";
+    std::string name = frame.name->name()->c_str();
+    char number[32];
+    switch (frame.kind) {
+    case ProfFrame::QUALIFIED:
+	return name + frame.op->name()->c_str() + frame.member->name()->c_str();
+    case ProfFrame::INDEXED_SYMBOL:
+	return name + "[[" + frame.member->name()->c_str() + "]]";
+    case ProfFrame::INDEXED_STRING:
+	return name + "[[\"" + frame.text + "\"]]";
+    case ProfFrame::INDEXED_NUMBER:
+	snprintf(number, sizeof(number), "%.0f", frame.number);
+	return name + "[[" + number + "]]";
+    default:
+	return name;
     }
-#endif
+}
 
-    /* I believe it would be slightly safer to place this _after_ the
-       next two bits, along with the signal() call. LT */
-#ifdef Win32
-    ResumeThread(MainThread);
-#endif /* Win32 */
+static void appendPosition(std::string& buf, int fnum, int line)
+{
+    if (fnum)
+	buf += std::to_string(fnum) + "#" + std::to_string(line) + " ";
+}
 
-    for (int i = prevnum; i < R_Line_Profiling; i++)
+static void writeSample(const ProfSample& sample, int* files_written)
+{
+    for (int i = *files_written; i < sample.nfiles; i++)
 	fprintf(R_ProfileOutfile, "#File %d: %s\n", i, R_Srcfiles[i-1]);
+    if (sample.nfiles > *files_written)
+	*files_written = sample.nfiles;
+
+    std::string buf;
+    std::vector<uint64_t> stack;
+    if (R_Mem_Profiling) {
+	for (int i = 0; i < 4; i++)
+	    buf += ":" + std::to_string(sample.mem[i]);
+	buf += ":";
+    }
+    if (R_GC_Profiling && sample.gc) {
+	buf += "\"<GC>\" ";
+	if (R_ProfStacks)
+	    stack.push_back(R_ProfStackNames->intern("<GC>"));
+    }
+    if (sample.jit) {
+	buf += "\"<JIT>\" ";
+	if (R_ProfStacks)
+	    stack.push_back(R_ProfStackNames->intern("<JIT>"));
+    }
+    if (R_Line_Profiling)
+	appendPosition(buf, sample.fnum, sample.line);
+    for (int i = 0; i < sample.depth; i++) {
+	std::string name = frameName(sample.frames[i]);
+	buf += "\"" + name + "\" ";
+	if (R_Line_Profiling)
+	    appendPosition(buf, sample.frames[i].fnum, sample.frames[i].line);
+	if (R_ProfStacks)
+	    stack.push_back(R_ProfStackNames->intern(name));
+    }
+
+    if (!buf.empty())
+	fprintf(R_ProfileOutfile, "%s\n", buf.c_str());
+    if (R_ProfStacks && !stack.empty())
+	++(*R_ProfStacks)[stack];
+}
 
-    if(strlen(buf))
-	fprintf(R_ProfileOutfile, "%s\n", buf);
-
-#ifndef Win32
-    signal(SIGPROF, doprof);
-#endif /* not Win32 */
+static void drainProfile(int files_written)
+{
+#ifdef HAVE_PTHREAD
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGPROF);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+#endif
+    bool stopping;
+    do {
+	stopping = R_ProfStopping.load(std::memory_order_acquire);
+	size_t tail = R_ProfTail.load(std::memory_order_relaxed);
+	size_t head = R_ProfHead.load(std::memory_order_acquire);
+	for (; tail != head; ++tail) {
+	    writeSample(R_ProfRing[tail % PROF_RING_SIZE], &files_written);
+	    R_ProfTail.store(tail + 1, std::memory_order_release);
+	}
+	if (!stopping)
+	    std::this_thread::sleep_for(
+		std::chrono::milliseconds(PROF_DRAIN_MILLIS));
+    } while (!stopping);
+}
 
+static void writeStacks()
+{
+    if (R_ProfileFoldedfile) {
+	/* One line per stack, outermost function first. */
+	for (const auto& entry : *R_ProfStacks) {
+	    const std::vector<uint64_t>& stack = entry.first;
+	    for (size_t i = stack.size(); i > 0; --i)
+		fprintf(R_ProfileFoldedfile, "%s%s",
+			R_ProfStackNames->str(stack[i - 1]).c_str(),
+			i > 1 ? ";" : "");
+	    fprintf(R_ProfileFoldedfile, " %llu\n",
+		    static_cast<unsigned long long>(entry.second));
+	}
+	if (fclose(R_ProfileFoldedfile) != 0)
+	    Rf_warning(_("Rprof: error writing the folded stacks"));
+	R_ProfileFoldedfile = nullptr;
+    }
+    if (R_ProfilePprofFile) {
+	PprofProfile& profile = *R_ProfStackNames;
+	int64_t period = int64_t(R_Profile_Interval) * 1000;
+	profile.addSampleType("samples", "count");
+	profile.addSampleType("cpu", "nanoseconds");
+	int64_t count = 0;
+	for (const auto& entry : *R_ProfStacks) {
+	    int64_t n = entry.second;
+	    profile.addSample(entry.first, {n, n * period});
+	    count += n;
+	}
+	profile.setPeriod("cpu", "nanoseconds", period);
+	profile.setTime(0, count * period);
+	bool ok = profile.write(R_ProfilePprofFile);
+	if (fclose(R_ProfilePprofFile) != 0 || !ok)
+	    Rf_warning(_("Rprof: error writing the pprof profile"));
+	R_ProfilePprofFile = nullptr;
+    }
 }
 
 #ifdef Win32
@@ -360,7 +608,15 @@ static void __cdecl ProfileThread(void *pwait)
 #else /* not Win32 */
 static void doprof_null(int sig)
 {
-    signal(SIGPROF, doprof_null);
+}
+
+static void setProfHandler(void (*handler)(int))
+{
+    struct sigaction action;
+    action.sa_handler = handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGPROF, &action, nullptr);
 }
 #endif /* not Win32 */
 
@@ -378,9 +634,23 @@ static void R_EndProfiling(void)
     itv.it_value.tv_sec = 0;
     itv.it_value.tv_usec = 0;
     setitimer(ITIMER_PROF, &itv, nullptr);
-    signal(SIGPROF, doprof_null);
+    setProfHandler(doprof_null);
 
 #endif /* not Win32 */
+    if (R_ProfDrainThread) {
+	R_ProfStopping.store(true, std::memory_order_release);
+	R_ProfDrainThread->join();
+	delete R_ProfDrainThread;
+	R_ProfDrainThread = nullptr;
+    }
+    if (R_ProfStacks)
+	writeStacks();
+    delete R_ProfStacks;
+    R_ProfStacks = nullptr;
+    delete R_ProfStackNames;
+    R_ProfStackNames = nullptr;
+    delete[] R_ProfRing;
+    R_ProfRing = nullptr;
     if(R_ProfileOutfile) fclose(R_ProfileOutfile);
     R_ProfileOutfile = nullptr;
     Evaluator::enableProfiling(false);
@@ -388,14 +658,32 @@ static void R_EndProfiling(void)
 	R_ReleaseObject(R_Srcfiles_buffer);
 	R_Srcfiles_buffer = nullptr;
     }
+    R_ProfSrcfileCount.store(0);
+    delete[] R_ProfSrcfiles;
+    R_ProfSrcfiles = nullptr;
     if (R_Profiling_Error)
 	Rf_warning(_("source files skipped by Rprof; please increase '%s'"),
 		R_Profiling_Error == 1 ? "numfiles" : "bufsize");
+    if (R_ProfDropped)
+	Rf_warning(_("Rprof: %lu samples dropped"),
+		   static_cast<unsigned long>(R_ProfDropped));
+}
+
+static FILE* openStackFile(SEXP filename, const char* mode)
+{
+    if (!filename || !strlen(CHAR(filename)))
+	return nullptr;
+    FILE* file = RC_fopen(filename, mode, TRUE);
+    if (file == nullptr)
+	Rf_error(_("Rprof: cannot open profile file '%s'"),
+		 Rf_translateChar(filename));
+    return file;
 }
 
 static void R_InitProfiling(SEXP filename, int append, double dinterval,
 			    int mem_profiling, int gc_profiling,
-			    int line_profiling, int numfiles, int bufsize)
+			    int line_profiling, int numfiles, int bufsize,
+			    SEXP folded, SEXP pprof)
 {
 #ifndef Win32
     struct itimerval itv;
@@ -411,6 +699,17 @@ static void R_InitProfiling(SEXP filename, int append, double dinterval,
     if (R_ProfileOutfile == nullptr)
 	Rf_error(_("Rprof: cannot open profile file '%s'"),
 	      Rf_translateChar(filename));
+    try {
+	R_ProfileFoldedfile = openStackFile(folded, "w");
+	R_ProfilePprofFile = openStackFile(pprof, "wb");
+    } catch (...) {
+	fclose(R_ProfileOutfile);
+	R_ProfileOutfile = nullptr;
+	if (R_ProfileFoldedfile)
+	    fclose(R_ProfileFoldedfile);
+	R_ProfileFoldedfile = nullptr;
+	throw;
+    }
     if(mem_profiling)
 	fprintf(R_ProfileOutfile, "memory profiling: ");
     if(gc_profiling)
@@ -424,6 +723,7 @@ static void R_InitProfiling(SEXP filename, int append, double dinterval,
 	reset_duplicate_counter();
 
     R_Profiling_Error = 0;
+    R_Profile_Interval = interval;
     R_Line_Profiling = line_profiling;
     R_GC_Profiling = gc_profiling;
     if (line_profiling) {
@@ -436,8 +736,25 @@ static void R_InitProfiling(SEXP filename, int append, double dinterval,
 	R_Srcfiles = reinterpret_cast<char **>( RAW(R_Srcfiles_buffer));
 	R_Srcfiles[0] = reinterpret_cast<char *>(RAW(R_Srcfiles_buffer)) + len1;
 	*(R_Srcfiles[0]) = '\0';
+	R_FilenameSymbol = Symbol::obtain("filename");
+	/* Different srcfiles may name the same file. */
+	R_ProfSrcfileMax = 4 * numfiles;
+	R_ProfSrcfiles = new ProfSrcfile[R_ProfSrcfileMax];
+	R_ProfSrcfileCount.store(0);
+	noteSrcref(R_Srcref);
     }
 
+    R_ProfRing = new ProfSample[PROF_RING_SIZE];
+    R_ProfHead.store(0);
+    R_ProfTail.store(0);
+    R_ProfStopping.store(false);
+    R_ProfDropped = 0;
+    if (R_ProfileFoldedfile || R_ProfilePprofFile) {
+	R_ProfStackNames = new PprofProfile;
+	R_ProfStacks = new std::map<std::vector<uint64_t>, uint64_t>;
+    }
+    R_ProfDrainThread = new std::thread(drainProfile, R_Line_Profiling);
+
 #ifdef Win32
     /* need to duplicate to make a real handle */
     DuplicateHandle(Proc, GetCurrentThread(), Proc, &MainThread,
@@ -452,7 +769,7 @@ static void R_InitProfiling(SEXP filename, int append, double dinterval,
     R_profiled_thread = pthread_self();
 #endif
 
-    signal(SIGPROF, doprof);
+    setProfHandler(doprof);
 
     itv.it_interval.tv_sec = 0;
     itv.it_interval.tv_usec = interval;
@@ -467,7 +784,7 @@ static void R_InitProfiling(SEXP filename, int append, double dinterval,
 extern "C"
 SEXP do_Rprof(SEXP args)
 {
-    SEXP filename;
+    SEXP filename, folded, pprof;
     int append_mode, mem_profiling, gc_profiling, line_profiling;
     double dinterval;
     int numfiles, bufsize;
@@ -483,14 +800,20 @@ SEXP do_Rprof(SEXP args)
     numfiles = Rf_asInteger(CAR(args));	      args = CDR(args);
     if (numfiles < 0)
 	Rf_error(_("invalid '%s' argument"), "numfiles");
-    bufsize = Rf_asInteger(CAR(args));
+    bufsize = Rf_asInteger(CAR(args));           args = CDR(args);
     if (bufsize < 0)
 	Rf_error(_("invalid '%s' argument"), "bufsize");
+    if (!Rf_isString(folded = CAR(args)) || (LENGTH(folded)) != 1)
+	Rf_error(_("invalid '%s' argument"), "folded");
+					      args = CDR(args);
+    if (!Rf_isString(pprof = CAR(args)) || (LENGTH(pprof)) != 1)
+	Rf_error(_("invalid '%s' argument"), "pprof");
 
     filename = STRING_ELT(filename, 0);
     if (LENGTH(filename))
 	R_InitProfiling(filename, append_mode, dinterval, mem_profiling,
-			gc_profiling, line_profiling, numfiles, bufsize);
+			gc_profiling, line_profiling, numfiles, bufsize,
+			STRING_ELT(folded, 0), STRING_ELT(pprof, 0));
     else
 	R_EndProfiling();
     return R_NilValue;
@@ -1188,6 +1511,10 @@ SEXP attribute_hidden do_begin(SEXP call, SEXP op, SEXP args, SEXP rho)
 	int i = 1;
 	while (args != R_NilValue) {
 	    R_Srcref = getSrcref(srcrefs, i++);
+#ifdef R_PROFILING
+	    if (R_Line_Profiling)
+		noteSrcref(R_Srcref);
+#endif
 	    if (ENV_DEBUG(rho)) {
 		Rf_SrcrefPrompt("debug", R_Srcref);
 		Rf_PrintValue(CAR(args));
@@ -1742,6 +2069,10 @@ SEXP attribute_hidden do_eval(SEXP call, SEXP op, SEXP args, SEXP rho)
 	    try {
 		for (i = 0 ; i < n ; i++) {
 		    R_Srcref = getSrcref(srcrefs, i); 
+#ifdef R_PROFILING
+		    if (R_Line_Profiling)
+			noteSrcref(R_Srcref);
+#endif
 		    tmp = Rf_eval(XVECTOR_ELT(expr, i), env);
 		}
 	    }
@@ -48,6 +48,7 @@
 
 #include <Defn.h>
 #include <float.h> /* for DBL_EPSILON */
+#include <stdint.h>
 #include "Rcomplex.h"
 #include <Rmath.h>
 #include <Print.h>
@@ -173,7 +174,7 @@ LDOUBLE private_nearbyintl(LDOUBLE x)
 #define NB 1000
 static void format_via_sprintf(double r, int d, int *kpower, int *nsig)
 {
-    static char buff[NB];
+    char buff[NB];
     int i;
     snprintf(buff, NB, "%#.*e", d - 1, r);
     *kpower = int( strtol(buff + (d + 2), nullptr, 10));
@@ -236,6 +237,25 @@ scientific(double *x, int *sgn, int *kpower, int *nsig, int *roundingwidens)
 	    *roundingwidens = 0;
             return;
         }
+        /* A whole number of at most R_print.digits digits needs no
+           rounding, so its digits can simply be counted. */
+        if (r < 1e15 && r == floor(r)) {
+            uint64_t v = uint64_t( r);
+            int ndig = 1, ntz = 0;
+            while (v % 10 == 0) {
+                v /= 10;
+                ntz++;
+            }
+            for (uint64_t u = v; u >= 10; u /= 10)
+                ndig++;
+            ndig += ntz;
+            if (ndig <= R_print.digits) {
+                *kpower = ndig - 1;
+                *nsig = ndig - ntz;
+                *roundingwidens = 0;
+                return;
+            }
+        }
         kp = int( floor(log10(r))) - R_print.digits + 1;/* r = |x|; 10^(kp + digits - 1) <= r */
 #if defined(HAVE_LONG_DOUBLE) && (SIZEOF_LONG_DOUBLE > SIZEOF_DOUBLE)
         long double r_prec = r;
@@ -281,7 +281,21 @@ static uLong getLong (gz_stream *s)
     return x;
 }
 
-static int R_gzread (gzFile file, voidp buf, unsigned len)
+/* Warns of the error, if any, that stopped reading file. */
+static void R_gzwarn(gzFile file)
+{
+    gz_stream *s = (gz_stream*) file;
+
+    if (s->z_err == Z_DATA_ERROR)
+	warning("invalid or incomplete compressed data");
+    else if (s->z_err == Z_ERRNO)
+	warning("error reading the file");
+}
+
+/* R_gzread() without its warnings, so that it can be run on a thread
+   other than R's: returns -1 if an error stopped reading before any
+   data were read, with the error left in s->z_err. */
+static int R_gzread_quiet(gzFile file, voidp buf, unsigned len)
 {
     gz_stream *s = (gz_stream*) file;
     Bytef *start = (Bytef*) buf; /* starting point for crc computation */
@@ -289,13 +303,7 @@ static int R_gzread (gzFile file, voidp buf, unsigned len)
 
     if (s == NULL || s->mode != 'r') return Z_STREAM_ERROR;
 
-    if (s->z_err == Z_DATA_ERROR) {
-	warning("invalid or incomplete compressed data");
-	return -1;
-    } else if(s->z_err == Z_ERRNO) {
-	warning("error reading the file");
-	return -1;
-    }
+    if (s->z_err == Z_DATA_ERROR || s->z_err == Z_ERRNO) return -1;
     if (s->z_err == Z_STREAM_END) return 0;  /* EOF */
 
     next_out = (Byte*) buf;
@@ -350,7 +358,6 @@ static int R_gzread (gzFile file, voidp buf, unsigned len)
             start = s->stream.next_out;
 
             if (getLong(s) != s->crc) {
-		warning("invalid or incomplete compressed data");
                 s->z_err = Z_DATA_ERROR;
             } else {
                 (void)getLong(s);
@@ -370,16 +377,20 @@ static int R_gzread (gzFile file, voidp buf, unsigned len)
     s->crc = crc32(s->crc, start, (uInt) (s->stream.next_out - start));
 
     if (len == s->stream.avail_out &&
-        (s->z_err == Z_DATA_ERROR || s->z_err == Z_ERRNO)) {
-	if(s->z_err == Z_DATA_ERROR)
-	    warning("invalid or incomplete compressed data");
-	else if(s->z_err == Z_ERRNO)
-	    warning("error reading the file");
+        (s->z_err == Z_DATA_ERROR || s->z_err == Z_ERRNO))
 	return -1;
-    }
     return (int)(len - s->stream.avail_out);
 }
 
+static int R_gzread (gzFile file, voidp buf, unsigned len)
+{
+    gz_stream *s = (gz_stream*) file;
+    int n = R_gzread_quiet(file, buf, len);
+
+    if (s && s->mode == 'r' && n < (int) len) R_gzwarn(file);
+    return n;
+}
+
 /* for devPS.c */
 char *R_gzgets(gzFile file, char *buf, int len)
 {
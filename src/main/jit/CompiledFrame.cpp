@@ -72,12 +72,12 @@ Frame::Binding* CompiledFrame::v_obtainBinding(const Symbol* symbol)
 {
     int location = m_descriptor->getLocation(symbol);
     if (location != -1) {
-	return m_bindings + location;
+	if (!slotSymbol(location))
+	    return assignSlot(location, symbol);
+	return slotBinding(location);
     }
-    if (!m_overflow) {
-	m_overflow = new map();
-    }
-    return &((*m_overflow)[symbol]);
+    Binding* binding = findSlot(symbol);
+    return binding ? binding : assignOverflowSlot(symbol);
 }
 
 
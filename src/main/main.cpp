@@ -65,6 +65,7 @@
 #include "rho/ProvenanceTracker.hpp"
 #include "rho/ReturnException.hpp"
 #include "rho/GCStackFrameBoundary.hpp"
+#include "rho/ThreadPool.hpp"
 
 using namespace rho;
 
@@ -969,6 +970,7 @@ void setup_Rmainloop(void)
     InitParser();
     InitTempDir(); /* must be before InitEd */
     InitMemory();
+    ThreadPool::initialize();
     InitNames();
     InitGlobalEnv();
     InitDynload();
@@ -30,8 +30,11 @@
 #include <Defn.h>
 #include <Internal.h>
 
+#include "apply.h"
 #include "rho/RAllocStack.hpp"
 
+using namespace rho;
+
 SEXP attribute_hidden
 do_mapply(/*const*/ rho::Expression* call, const rho::BuiltInFunction* op, rho::Environment* rho, rho::RObject* const* args, int num_args, const rho::PairList* tags)
 {
@@ -90,6 +93,14 @@ do_mapply(/*const*/ rho::Expression* call, const rho::BuiltInFunction* op, rho::
 
     SEXP ans = PROTECT(allocVector(VECSXP, longest));
 
+    // The elements are extracted directly unless some argument has
+    // a class, and so perhaps a method for '[['.
+    ElementApplier applier(SEXP_downcast<Expression*>(fcall), rho, m);
+    bool direct = true;
+    for (int j = 0; j < m; j++)
+	direct = direct
+	    && ElementApplier::isDirectlyIndexable(VECTOR_ELT(varyingArgs, j));
+
     for (int i = 0; i < longest; i++) {
 	for (int j = 0; j < m; j++) {
 	    counters[j] = (++counters[j] > lengths[j]) ? 1 : counters[j];
@@ -97,8 +108,12 @@ do_mapply(/*const*/ rho::Expression* call, const rho::BuiltInFunction* op, rho::
 		REAL(VECTOR_ELT(nindex, j))[0] = double( counters[j]);
 	    else
 		INTEGER(VECTOR_ELT(nindex, j))[0] = int( counters[j]);
+	    if (direct)
+		applier.setArgument(j, ElementApplier::element(
+					VECTOR_ELT(varyingArgs, j),
+					counters[j] - 1));
 	}
-	SEXP tmp = R_forceAndCall(fcall, m, rho);
+	SEXP tmp = (direct ? applier.apply() : R_forceAndCall(fcall, m, rho));
 	if (MAYBE_REFERENCED(tmp))
 	    tmp = duplicate(tmp);
 	SET_VECTOR_ELT(ans, i, tmp);
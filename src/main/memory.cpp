@@ -38,6 +38,7 @@
 #endif
 
 #include <R_ext/RS.h> /* for S4 allocation */
+#include "rho/AllocationProfiler.hpp"
 #include "rho/ComplexVector.hpp"
 #include "rho/ExpressionVector.hpp"
 #include "rho/FunctionContext.hpp"
@@ -587,6 +588,45 @@ SEXP do_Rprofmem(SEXP args)
 
 #endif /* R_MEMORY_PROFILING */
 
+/*******************************************/
+/* Sampling allocation profiler: see        */
+/* rho::AllocationProfiler                  */
+/*******************************************/
+
+static FILE *R_AllocProfileOutfile;
+
+static void R_EndAllocProfiling()
+{
+    if (R_AllocProfileOutfile == NULL)
+	return;
+    AllocationProfiler::stop();
+    bool ok = AllocationProfiler::writeProfile(R_AllocProfileOutfile);
+    ok = (fclose(R_AllocProfileOutfile) == 0) && ok;
+    R_AllocProfileOutfile = NULL;
+    if (!ok)
+	warning(_("Rprofalloc: error writing the profile"));
+}
+
+extern "C"
+SEXP do_Rprofalloc(SEXP args)
+{
+    if (!isString(CAR(args)) || (LENGTH(CAR(args))) != 1)
+	error(_("invalid '%s' argument"), "filename");
+    SEXP filename = STRING_ELT(CAR(args), 0);
+    double interval = asReal(CADR(args));
+    R_EndAllocProfiling();
+    if (strlen(CHAR(filename))) {
+	if (!R_FINITE(interval) || interval < 1)
+	    error(_("invalid '%s' argument"), "interval");
+	R_AllocProfileOutfile = RC_fopen(filename, "wb", TRUE);
+	if (R_AllocProfileOutfile == NULL)
+	    error(_("Rprofalloc: cannot open output file '%s'"),
+		  translateChar(filename));
+	AllocationProfiler::start(interval);
+    }
+    return R_NilValue;
+}
+
 /* RBufferUtils, moved from deparse.c */
 
 #include "RBufferUtils.h"
@@ -34,7 +34,9 @@
 #include "rho/Evaluator_Context.hpp"
 #include "rho/GCManager.hpp"
 #include "rho/GCStackRoot.hpp"
+#include "rho/IntVector.hpp"
 #include "rho/LogicalVector.hpp"
+#include "rho/RealVector.hpp"
 
 #include <Defn.h>
 #include <Internal.h>
@@ -925,6 +927,9 @@ void attribute_hidden Rf_InitNames()
 {
     // Logical constants.
     Logical::initialize();
+    // Shared small scalars.
+    SmallIntVectors::initialize();
+    SmallRealVectors::initialize();
 
     /* String constants (CHARSXP values) */
     String::initialize();
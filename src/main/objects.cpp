@@ -1620,14 +1620,16 @@ S3Launcher::create(RObject* object, std::string generic, std::string group,
 	ans(new S3Launcher(generic, group, call_env, table_env));
     ans->m_classes = static_cast<StringVector*>(R_data_class2(object));
 
+    std::shared_ptr<const MethodNames>
+	names(methodNames(generic, group, ans->m_classes));
+
     // Look for pukka method.  Need to interleave looking for generic
     // and group methods, e.g. if class(x) is c("foo", "bar") then
     // x > 3 should invoke "Ops.foo" rather than ">.bar".
     {
 	size_t len = ans->m_classes->size();
 	for (ans->m_index = 0; ans->m_index < len; ++ans->m_index) {
-	    const char *ss = Rf_translateChar((*ans->m_classes)[ans->m_index]);
-	    ans->m_symbol = Symbol::obtain(generic + "." + ss);
+	    ans->m_symbol = names->generic_methods[ans->m_index];
 	    ans->m_function
 		= findMethod(ans->m_symbol, call_env, table_env).first;
 	    if (ans->m_function) {
@@ -1645,7 +1647,7 @@ S3Launcher::create(RObject* object, std::string generic, std::string group,
 	    }
 	    if (!group.empty()) {
 		// Try for group method:
-		ans->m_symbol = Symbol::obtain(group + "." + ss);
+		ans->m_symbol = names->group_methods[ans->m_index];
 		ans->m_function
 		    = findMethod(ans->m_symbol, call_env, table_env).first;
 		if (ans->m_function) {
@@ -1657,7 +1659,7 @@ S3Launcher::create(RObject* object, std::string generic, std::string group,
     }
     if (!ans->m_function && allow_default) {
 	// Look for default method:
-	ans->m_symbol = Symbol::obtain(generic + ".default");
+	ans->m_symbol = names->default_method;
 	ans->m_function = findMethod(ans->m_symbol, call_env, table_env).first;
     }
     if (!ans->m_function)
@@ -41,12 +41,29 @@
 
 #include "Print.h"
 #include "RBufferUtils.h"
+#include <string>
 #include <vector>
 
 using namespace std;
 
 static R_StringBuffer cbuff = {nullptr, 0, MAXELTSIZE};
 
+/* Can the string be pasted as it is, without translation?  True of
+   ASCII and UTF-8 strings: a result built only from such strings is
+   their bytes end to end, in UTF-8 if any piece is. */
+static bool pasteAsIs(SEXP cs)
+{
+    return cs == NA_STRING || IS_ASCII(cs) || IS_UTF8(cs);
+}
+
+static bool pasteAsIs(SEXP x, R_xlen_t n)
+{
+    for (R_xlen_t i = 0; i < n; i++)
+	if (!pasteAsIs(STRING_ELT(x, i)))
+	    return false;
+    return true;
+}
+
 /*
   .Internal(paste (args, sep, collapse))
   .Internal(paste0(args, collapse))
@@ -54,6 +71,10 @@ static R_StringBuffer cbuff = {nullptr, 0, MAXELTSIZE};
  * do_paste uses two passes to paste the arguments (in CAR(args)) together.
  * The first pass calculates the width of the paste buffer,
  * then it is alloc-ed and the second pass stuffs the information in.
+ *
+ * When no string needs translating, which is the usual case, each
+ * result is instead built in a single pass by appending the pieces to
+ * a reused buffer, and interned from there.
  */
 
 /* Note that NA_STRING is not handled separately here.  This is
@@ -134,7 +155,39 @@ SEXP attribute_hidden do_paste(/*const*/ rho::Expression* call, const rho::Built
 
     PROTECT(ans = allocVector(STRSXP, maxlen));
 
-    for (i = 0; i < maxlen; i++) {
+    bool as_is = !use_sep || nx == 1 || pasteAsIs(sep);
+    for (j = 0; as_is && j < nx; j++)
+	as_is = pasteAsIs(VECTOR_ELT(x, j), XLENGTH(VECTOR_ELT(x, j)));
+    if (as_is) {
+	std::vector<SEXP> cols(nx);
+	std::vector<R_xlen_t> lens(nx);
+	for (j = 0; j < nx; j++) {
+	    cols[j] = VECTOR_ELT(x, j);
+	    lens[j] = XLENGTH(cols[j]);
+	}
+	const char *asep = use_sep ? CHAR(sep) : "";
+	size_t asepw = use_sep ? LENGTH(sep) : 0;
+	std::string row;
+	for (i = 0; i < maxlen; i++) {
+	    bool utf8 = use_sep && nx > 1 && sepUTF8;
+	    row.clear();
+	    for (j = 0; j < nx; j++) {
+		if (lens[j] > 0) {
+		    SEXP cs = STRING_ELT(cols[j], i % lens[j]);
+		    row.append(CHAR(cs), LENGTH(cs));
+		    utf8 = utf8 || IS_UTF8(cs);
+		}
+		if (asepw != 0 && j != nx - 1)
+		    row.append(asep, asepw);
+	    }
+	    if (row.size() > INT_MAX)
+		error(_("result would exceed 2^31-1 bytes"));
+	    SET_STRING_ELT(ans, i,
+			   rho::String::obtain(row, utf8 ? CE_UTF8 : CE_NATIVE));
+	}
+    }
+
+    for (i = 0; !as_is && i < maxlen; i++) {
 	/* Strategy for marking the encoding: if all inputs (including
 	 * the separator) are ASCII, so is the output and we don't
 	 * need to mark.  Otherwise if all non-ASCII inputs are of
@@ -222,7 +275,28 @@ SEXP attribute_hidden do_paste(/*const*/ rho::Expression* call, const rho::Built
 
     /* Now collapse, if required. */
 
-    if(collapse != R_NilValue && (nx = XLENGTH(ans)) > 0) {
+    if(collapse != R_NilValue && (nx = XLENGTH(ans)) > 0
+       && pasteAsIs(STRING_ELT(collapse, 0)) && pasteAsIs(ans, nx)) {
+	sep = STRING_ELT(collapse, 0);
+	size_t total = (nx - 1) * size_t(LENGTH(sep));
+	bool utf8 = IS_UTF8(sep);
+	for (i = 0; i < nx; i++) {
+	    total += LENGTH(STRING_ELT(ans, i));
+	    utf8 = utf8 || IS_UTF8(STRING_ELT(ans, i));
+	}
+	if (total > INT_MAX)
+	    error(_("result would exceed 2^31-1 bytes"));
+	std::string res;
+	res.reserve(total);
+	for (i = 0; i < nx; i++) {
+	    if (i > 0)
+		res.append(CHAR(sep), LENGTH(sep));
+	    res.append(CHAR(STRING_ELT(ans, i)), LENGTH(STRING_ELT(ans, i)));
+	}
+	UNPROTECT(1);
+	PROTECT(ans = Rf_ScalarString(
+		    rho::String::obtain(res, utf8 ? CE_UTF8 : CE_NATIVE)));
+    } else if(collapse != R_NilValue && (nx = XLENGTH(ans)) > 0) {
 	sep = STRING_ELT(collapse, 0);
 	use_UTF8 = IS_UTF8(sep);
 	use_Bytes = IS_BYTES(sep);
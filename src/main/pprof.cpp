@@ -0,0 +1,162 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Writer for pprof profiles: see pprof.h.  The message is simple
+ * enough to encode by hand.
+ */
+
+#include "pprof.h"
+
+using namespace rho;
+
+namespace {
+    // Encoders for the protocol buffer wire format, appending to a
+    // message under construction.
+    void varint(std::string& msg, uint64_t value)
+    {
+	while (value >= 0x80) {
+	    msg += char((value & 0x7f) | 0x80);
+	    value >>= 7;
+	}
+	msg += char(value);
+    }
+
+    void intField(std::string& msg, int field, uint64_t value)
+    {
+	varint(msg, uint64_t(field) << 3);
+	varint(msg, value);
+    }
+
+    // Also used for embedded messages.
+    void bytesField(std::string& msg, int field, const std::string& bytes)
+    {
+	varint(msg, (uint64_t(field) << 3) | 2);
+	varint(msg, bytes.size());
+	msg += bytes;
+    }
+
+    template <typename T>
+    void packedField(std::string& msg, int field, const std::vector<T>& values)
+    {
+	std::string packed;
+	for (T value : values)
+	    varint(packed, uint64_t(value));
+	bytesField(msg, field, packed);
+    }
+}
+
+PprofProfile::PprofProfile()
+    : m_period(0), m_time_nanos(0), m_duration_nanos(0)
+{
+    intern("");
+}
+
+uint64_t PprofProfile::intern(const std::string& str)
+{
+    auto it = m_string_index.find(str);
+    if (it != m_string_index.end())
+	return it->second;
+    uint64_t index = m_strings.size();
+    m_strings.push_back(str);
+    m_string_index[str] = index;
+    return index;
+}
+
+void PprofProfile::addSampleType(const std::string& type,
+				 const std::string& unit)
+{
+    std::string value_type;
+    intField(value_type, 1, intern(type));
+    intField(value_type, 2, intern(unit));
+    bytesField(m_sample_types, 1, value_type);
+}
+
+void PprofProfile::setPeriod(const std::string& type, const std::string& unit,
+			     int64_t period)
+{
+    m_period_type.clear();
+    intField(m_period_type, 1, intern(type));
+    intField(m_period_type, 2, intern(unit));
+    m_period = period;
+}
+
+void PprofProfile::setTime(int64_t time_nanos, int64_t duration_nanos)
+{
+    m_time_nanos = time_nanos;
+    m_duration_nanos = duration_nanos;
+}
+
+void PprofProfile::addSample(const std::vector<uint64_t>& stack,
+			     const std::vector<int64_t>& values,
+			     const std::vector<Label>& labels)
+{
+    std::string sample;
+    packedField(sample, 1, stack);
+    packedField(sample, 2, values);
+    for (const Label& label : labels) {
+	std::string msg;
+	intField(msg, 1, label.key);
+	if (label.str)
+	    intField(msg, 2, label.str);
+	else {
+	    intField(msg, 3, label.num);
+	    if (label.num_unit)
+		intField(msg, 4, label.num_unit);
+	}
+	bytesField(sample, 3, msg);
+    }
+    bytesField(m_samples, 2, sample);
+    for (uint64_t function : stack) {
+	if (function >= m_is_function.size())
+	    m_is_function.resize(function + 1);
+	m_is_function[function] = true;
+    }
+}
+
+bool PprofProfile::write(std::FILE* file)
+{
+    std::string profile = m_sample_types + m_samples;
+    for (uint64_t id = 0; id < m_is_function.size(); ++id) {
+	if (!m_is_function[id])
+	    continue;
+	std::string line, location, function;
+	intField(line, 1, id);
+	intField(location, 1, id);
+	bytesField(location, 4, line);
+	bytesField(profile, 4, location);
+	intField(function, 1, id);
+	intField(function, 2, id);
+	intField(function, 3, id);
+	bytesField(profile, 5, function);
+    }
+    for (const std::string& str : m_strings)
+	bytesField(profile, 6, str);
+    intField(profile, 9, m_time_nanos);
+    intField(profile, 10, m_duration_nanos);
+    if (!m_period_type.empty()) {
+	bytesField(profile, 11, m_period_type);
+	intField(profile, 12, m_period);
+    }
+    return std::fwrite(profile.data(), 1, profile.size(), file)
+	== profile.size() && std::fflush(file) == 0;
+}
@@ -0,0 +1,94 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Writer for profiles in the format read by pprof: a serialized
+ * perftools.profiles.Profile message, as defined by profile.proto in
+ * the pprof sources.  Used by Rprof() and Rprofalloc().
+ *
+ * Profiles written here identify code by function name only.  Each
+ * name is a Function, and also the Location of a single Line in it;
+ * both take as their id the index of the name in the string table.
+ */
+
+#ifndef PPROF_H
+#define PPROF_H 1
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rho {
+    class PprofProfile {
+    public:
+	// A sample label, with either a string or a numeric value.
+	struct Label {
+	    uint64_t key;
+	    uint64_t str;
+	    int64_t num;
+	    uint64_t num_unit;
+	};
+
+	PprofProfile();
+
+	// Index of str in the string table, adding it if need be.
+	uint64_t intern(const std::string& str);
+
+	const std::string& str(uint64_t index) const
+	{
+	    return m_strings[index];
+	}
+
+	// Sample types must all be added before the first sample.
+	void addSampleType(const std::string& type, const std::string& unit);
+
+	void setPeriod(const std::string& type, const std::string& unit,
+		       int64_t period);
+
+	void setTime(int64_t time_nanos, int64_t duration_nanos);
+
+	// 'stack' lists the interned names of the functions on the
+	// stack, innermost first; 'values' has one entry per sample
+	// type.
+	void addSample(const std::vector<uint64_t>& stack,
+		       const std::vector<int64_t>& values,
+		       const std::vector<Label>& labels
+		       = std::vector<Label>());
+
+	// Returns true iff the profile was written without error.
+	bool write(std::FILE* file);
+    private:
+	std::vector<std::string> m_strings;
+	std::unordered_map<std::string, uint64_t> m_string_index;
+	std::vector<bool> m_is_function;
+	std::string m_sample_types;
+	std::string m_samples;
+	std::string m_period_type;
+	int64_t m_period;
+	int64_t m_time_nanos;
+	int64_t m_duration_nanos;
+    };
+}
+
+#endif /* PPROF_H */
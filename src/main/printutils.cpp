@@ -128,6 +128,36 @@ R_size_t R_Decode2Long(char *p, int *ierr)
 /* There is no documented (or enforced) limit on 'w' here,
    so use snprintf */
 #define NB 1000
+
+/* Writes the whole number v, |v| < 1e18, right-justified in a field of
+   width w, as snprintf(buff, NB, "%*.0f") would.  Whole numbers are
+   the commonest values formatted, and this avoids the overhead of
+   parsing a format and of the general conversion in the C library. */
+static void encodeWhole(char *buff, long long v, int w)
+{
+    char digits[24], *p = digits + sizeof digits;
+    unsigned long long u = (v < 0) ? 0ULL - (unsigned long long) v : v;
+    *--p = '\0';
+    do {
+	*--p = char('0' + u % 10);
+	u /= 10;
+    } while (u);
+    if (v < 0) *--p = '-';
+    int len = int(digits + sizeof digits - 1 - p);
+    int pad = min(w, NB-1) - len;
+    if (pad > 0) {
+	memset(buff, ' ', pad);
+	buff += pad;
+    }
+    memcpy(buff, p, len + 1);
+}
+
+/* Is x a whole number that encodeWhole() can write? */
+static R_INLINE bool isSmallWhole(double x)
+{
+    return fabs(x) < 1e15 && x == floor(x);
+}
+
 const char *EncodeLogical(int x, int w)
 {
     static char buff[NB];
@@ -142,7 +172,7 @@ const char *EncodeInteger(int x, int w)
 {
     static char buff[NB];
     if(x == NA_INTEGER) snprintf(buff, NB, "%*s", min(w, (NB-1)), CHAR(R_print.na_string));
-    else snprintf(buff, NB, "%*d", min(w, (NB-1)), x);
+    else encodeWhole(buff, x, w);
     buff[NB-1] = '\0';
     return buff;
 }
@@ -185,10 +215,9 @@ const char *EncodeReal(double x, int w, int d, int e, char cdec)
     return EncodeReal0(x, w, d, e, dec);
 }
 
-const char *EncodeReal0(double x, int w, int d, int e, const char *dec)
+void EncodeRealBuf(char *buff, double x, int w, int d, int e, char cdec)
 {
-    static char buff[NB], buff2[2*NB];
-    char fmt[20], *out = buff;
+    char fmt[20];
 
     /* IEEE allows signed zeros (yuck!) */
     if (x == 0.0) x = 0.0;
@@ -208,12 +237,26 @@ const char *EncodeReal0(double x, int w, int d, int e, const char *dec)
 	    snprintf(buff, NB, fmt, x);
 	}
     }
+    else if (d == 0 && isSmallWhole(x))
+	encodeWhole(buff, (long long) x, w);
     else { /* e = 0 */
 	sprintf(fmt,"%%%d.%df", min(w, (NB-1)), d);
 	snprintf(buff, NB, fmt, x);
     }
     buff[NB-1] = '\0';
 
+    if(cdec != '.')
+	for(char *p = buff; *p; p++)
+	    if(*p == '.') *p = cdec;
+}
+
+const char *EncodeReal0(double x, int w, int d, int e, const char *dec)
+{
+    static char buff[NB], buff2[2*NB];
+    char *out = buff;
+
+    EncodeRealBuf(buff, x, w, d, e, '.');
+
     if(strcmp(dec, ".")) {
 	char *p, *q;
 	for(p = buff, q = buff2; *p; p++) {
@@ -251,6 +294,8 @@ static const char
 	    snprintf(buff, NB, fmt, x);
 	}
     }
+    else if (d == 0 && isSmallWhole(x))
+	encodeWhole(buff, (long long) x, w);
     else { /* e = 0 */
 	sprintf(fmt,"%%%d.%df", min(w, (NB-1)), d);
 	snprintf(buff, NB, fmt, x);
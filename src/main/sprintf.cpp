@@ -33,6 +33,8 @@
 #include <Internal.h>
 #include "RBufferUtils.h"
 #include <R_ext/RS.h> /* for Calloc/Free */
+#include <string>
+#include <vector>
 #ifdef Win32
 #include <trioremap.h>
 #endif
@@ -80,6 +82,171 @@ static Rboolean checkfmt(const char *fmt, const char *pattern)
    ((use_UTF8) ? translateCharUTF8(STRING_ELT(_STR_, _i_))  \
     : translateChar(STRING_ELT(_STR_, _i_)))
 
+#define _my_sprintf(_X_)						\
+    {									\
+	int nc = snprintf(bit, MAXLINE+1, fmtp, _X_);			\
+	if (nc > MAXLINE)						\
+	    error(_("required resulting string length %d is greater than maximal %d"), \
+		  nc, MAXLINE);						\
+    }
+
+/* Format element ns of _this, of length thislen, by the conversion
+   specification fmtp, which may be altered.  Returns a string to be
+   output as it is, or nullptr if the result is in bit. */
+static const char *formatArg(char *bit, char *fmtp, SEXP _this, int thislen,
+			     int ns, Rboolean use_UTF8)
+{
+    const char *ss = nullptr;
+
+    switch(TYPEOF(_this)) {
+    case LGLSXP:
+	{
+	    int x = LOGICAL(_this)[ns % thislen];
+	    if (checkfmt(fmtp, "di"))
+		error(_("invalid format '%s'; %s"), fmtp,
+		      _("use format %d or %i for logical objects"));
+	    if (x == NA_LOGICAL) {
+		fmtp[strlen(fmtp)-1] = 's';
+		_my_sprintf("NA")
+	    } else {
+		_my_sprintf(x)
+	    }
+	    break;
+	}
+    case INTSXP:
+	{
+	    int x = INTEGER(_this)[ns % thislen];
+	    if (checkfmt(fmtp, "dioxX"))
+		error(_("invalid format '%s'; %s"), fmtp,
+		      _("use format %d, %i, %o, %x or %X for integer objects"));
+	    if (x == NA_INTEGER) {
+		fmtp[strlen(fmtp)-1] = 's';
+		_my_sprintf("NA")
+	    } else {
+		_my_sprintf(x)
+	    }
+	    break;
+	}
+    case REALSXP:
+	{
+	    double x = REAL(_this)[ns % thislen];
+	    if (checkfmt(fmtp, "aAfeEgG"))
+		error(_("invalid format '%s'; %s"), fmtp,
+		      _("use format %f, %e, %g or %a for numeric objects"));
+	    if (R_FINITE(x)) {
+		_my_sprintf(x)
+	    } else {
+		char *p = Rf_strchr(fmtp, '.');
+		if (p) {
+		    *p++ = 's'; *p ='\0';
+		} else
+		    fmtp[strlen(fmtp)-1] = 's';
+		if (ISNA(x)) {
+		    if (strcspn(fmtp, " ") < strlen(fmtp))
+			_my_sprintf(" NA")
+		    else
+			_my_sprintf("NA")
+		} else if (ISNAN(x)) {
+		    if (strcspn(fmtp, " ") < strlen(fmtp))
+			_my_sprintf(" NaN")
+		    else
+			_my_sprintf("NaN")
+		} else if (x == R_PosInf) {
+		    if (strcspn(fmtp, "+") < strlen(fmtp))
+			_my_sprintf("+Inf")
+		    else if (strcspn(fmtp, " ") < strlen(fmtp))
+			_my_sprintf(" Inf")
+		    else
+			_my_sprintf("Inf")
+		} else if (x == R_NegInf)
+		    _my_sprintf("-Inf")
+	    }
+	    break;
+	}
+    case STRSXP:
+	/* NA_STRING will be printed as 'NA' */
+	if (checkfmt(fmtp, "s"))
+	    error(_("invalid format '%s'; %s"), fmtp,
+		  _("use format %s for character objects"));
+
+	ss = TRANSLATE_CHAR(_this, ns % thislen);
+	if(fmtp[1] != 's') {
+	    if(strlen(ss) > MAXLINE)
+		warning(_("likely truncation of character string to %d characters"),
+			MAXLINE-1);
+	    _my_sprintf(ss)
+	    bit[MAXLINE] = '\0';
+	    ss = nullptr;
+	}
+	break;
+
+    default:
+	error(_("unsupported type"));
+	break;
+    }
+    return ss;
+}
+
+/* A format compiled for use on every row: literal text, or a
+   conversion specification and the argument it converts. */
+struct FormatOp {
+    std::string text;
+    int arg;  // -1 for literal text.
+};
+
+/* Split an ASCII format into ops as the row loop in do_sprintf parses
+   it.  Returns false for formats using '*', which are left to be
+   parsed for each row. */
+static bool compileFormat(const char *formatString, int nargs,
+			  std::vector<FormatOp>& ops)
+{
+    size_t n = strlen(formatString), chunk;
+    int cnt = 0;
+
+    ops.clear();
+    for (size_t cur = 0; cur < n; cur += chunk) {
+	const char *curFormat = formatString + cur;
+	if (*curFormat != '%') {
+	    const char *ch = strchr(curFormat, '%');
+	    chunk = ch ? size_t(ch - curFormat) : n - cur;
+	    ops.push_back({std::string(curFormat, chunk), -1});
+	} else if (cur < n - 1 && curFormat[1] == '%') {
+	    chunk = 2;
+	    ops.push_back({"%", -1});
+	} else {
+	    chunk = strcspn(curFormat + 1, "diosfeEgGxXaA") + 2;
+	    if (cur + chunk > n)
+		return false;
+	    std::string fmt(curFormat, chunk);
+	    if (fmt.find('*') != std::string::npos)
+		return false;
+	    int nthis = -1;
+	    if (fmt.size() > 3 && fmt[1] >= '1' && fmt[1] <= '9') {
+		if (fmt[2] == '$') {
+		    nthis = fmt[1] - '0' - 1;
+		    fmt.erase(1, 2);
+		} else if (fmt[2] >= '0' && fmt[2] <= '9' && fmt[3] == '$') {
+		    nthis = 10*(fmt[1] - '0') + fmt[2] - '0' - 1;
+		    fmt.erase(1, 3);
+		}
+		if (nthis >= nargs)
+		    return false;
+	    }
+	    if (fmt[fmt.size() - 1] == '%')
+		ops.push_back({fmt, -1});
+	    else {
+		if (nthis < 0) {
+		    if (cnt >= nargs)
+			return false;
+		    nthis = cnt++;
+		}
+		ops.push_back({fmt, nthis});
+	    }
+	}
+    }
+    return true;
+}
+
 
 SEXP attribute_hidden do_sprintf(/*const*/ rho::Expression* call, const rho::BuiltInFunction* op, rho::Environment* env, rho::RObject* const* args, int num_args, const rho::PairList* tags)
 {
@@ -96,14 +263,6 @@ SEXP attribute_hidden do_sprintf(/*const*/ rho::Expression* call, const rho::Bui
     static R_StringBuffer outbuff = {nullptr, 0, MAXELTSIZE};
     Rboolean has_star, use_UTF8;
 
-#define _my_sprintf(_X_)						\
-    {									\
-	int nc = snprintf(bit, MAXLINE+1, fmtp, _X_);			\
-	if (nc > MAXLINE)						\
-	    error(_("required resulting string length %d is greater than maximal %d"), \
-		  nc, MAXLINE);						\
-    }
-
     nargs = num_args;
     /* grab the format string */
     format = num_args ? args[0] : nullptr;
@@ -341,92 +500,7 @@ SEXP attribute_hidden do_sprintf(/*const*/ rho::Expression* call, const rho::Bui
 			if(!did_this)
 			    CHECK_this_length;
 
-			switch(TYPEOF(_this)) {
-			case LGLSXP:
-			    {
-				int x = LOGICAL(_this)[ns % thislen];
-				if (checkfmt(fmtp, "di"))
-				    error(_("invalid format '%s'; %s"), fmtp,
-					  _("use format %d or %i for logical objects"));
-				if (x == NA_LOGICAL) {
-				    fmtp[strlen(fmtp)-1] = 's';
-				    _my_sprintf("NA")
-				} else {
-				    _my_sprintf(x)
-				}
-				break;
-			    }
-			case INTSXP:
-			    {
-				int x = INTEGER(_this)[ns % thislen];
-				if (checkfmt(fmtp, "dioxX"))
-				    error(_("invalid format '%s'; %s"), fmtp,
-					  _("use format %d, %i, %o, %x or %X for integer objects"));
-				if (x == NA_INTEGER) {
-				    fmtp[strlen(fmtp)-1] = 's';
-				    _my_sprintf("NA")
-				} else {
-				    _my_sprintf(x)
-				}
-				break;
-			    }
-			case REALSXP:
-			    {
-				double x = REAL(_this)[ns % thislen];
-				if (checkfmt(fmtp, "aAfeEgG"))
-				    error(_("invalid format '%s'; %s"), fmtp,
-					  _("use format %f, %e, %g or %a for numeric objects"));
-				if (R_FINITE(x)) {
-				    _my_sprintf(x)
-				} else {
-				    char *p = Rf_strchr(fmtp, '.');
-				    if (p) {
-					*p++ = 's'; *p ='\0';
-				    } else
-					fmtp[strlen(fmtp)-1] = 's';
-				    if (ISNA(x)) {
-					if (strcspn(fmtp, " ") < strlen(fmtp))
-					    _my_sprintf(" NA")
-					else
-					    _my_sprintf("NA")
-				    } else if (ISNAN(x)) {
-					if (strcspn(fmtp, " ") < strlen(fmtp))
-					    _my_sprintf(" NaN")
-					else
-					    _my_sprintf("NaN")
-				    } else if (x == R_PosInf) {
-					if (strcspn(fmtp, "+") < strlen(fmtp))
-					    _my_sprintf("+Inf")
-					else if (strcspn(fmtp, " ") < strlen(fmtp))
-					    _my_sprintf(" Inf")
-					else
-					    _my_sprintf("Inf")
-				    } else if (x == R_NegInf)
-					_my_sprintf("-Inf")
-				}
-				break;
-			    }
-			case STRSXP:
-			    /* NA_STRING will be printed as 'NA' */
-			    if (checkfmt(fmtp, "s"))
-				error(_("invalid format '%s'; %s"), fmtp,
-				      _("use format %s for character objects"));
-
-			    ss = TRANSLATE_CHAR(_this, ns % thislen);
-			    if(fmtp[1] != 's') {
-				if(strlen(ss) > MAXLINE)
-				    warning(_("likely truncation of character string to %d characters"),
-					    MAXLINE-1);
-				_my_sprintf(ss)
-				bit[MAXLINE] = '\0';
-				ss = nullptr;
-			    }
-			    break;
-
-			default:
-			    error(_("unsupported type"));
-			    break;
-			}
+			ss = formatArg(bit, fmtp, _this, thislen, ns, use_UTF8);
 
 			UNPROTECT(1);
 		    }
@@ -455,6 +529,37 @@ SEXP attribute_hidden do_sprintf(/*const*/ rho::Expression* call, const rho::Bui
 	}
 	SET_STRING_ELT(ans, ns, mkCharCE(outputString,
 					 use_UTF8 ? CE_UTF8 : CE_NATIVE));
+
+	/* Row 0 has done any coercion of the arguments, so a single
+	   ASCII format can now be compiled once for the other rows. */
+	std::vector<FormatOp> ops;
+	if (ns == 0 && maxlen > 1 && nfmt == 1
+	    && IS_ASCII(STRING_ELT(format, 0))
+	    && compileFormat(formatString, nargs, ops)) {
+	    std::string out;
+	    for (ns = 1; ns < maxlen; ns++) {
+		use_UTF8 = FALSE;
+		for (i = 0; i < nargs && !use_UTF8; i++)
+		    use_UTF8 = RHOCONSTRUCT(Rboolean, isString(a[i])
+				&& IS_UTF8(STRING_ELT(a[i], ns % lens[i])));
+		out.clear();
+		for (const FormatOp& fop : ops) {
+		    if (fop.arg < 0) {
+			out += fop.text;
+			continue;
+		    }
+		    /* formatArg may alter the specification. */
+		    strcpy(fmt, fop.text.c_str());
+		    _this = a[fop.arg];
+		    const char *ss = formatArg(bit, fmt, _this, length(_this),
+					       ns, use_UTF8);
+		    out += ss ? ss : bit;
+		}
+		SET_STRING_ELT(ans, ns, rho::String::obtain(out,
+					 use_UTF8 ? CE_UTF8 : CE_NATIVE));
+	    }
+	    break;
+	}
     } /* end for(ns ...) */
 
     UNPROTECT(nprotect);
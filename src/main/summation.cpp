@@ -0,0 +1,268 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 1998-2015   The R Core Team
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Multi-threaded, cache-friendly summation kernels: see summation.h.
+ *
+ * Columns are independent, so column sums simply divide the columns
+ * between threads.  Row sums divide the rows into tiles small enough
+ * for the accumulators to stay in L1 cache, and sweep each tile
+ * across all the columns in turn, so that every access to x is
+ * unit-stride; tiles are divided between threads.  Each result is
+ * accumulated in exactly the order a single-threaded loop would use,
+ * so results do not depend on the number of threads.
+ *
+ * Double values are accumulated in LDOUBLE, as R has always done.
+ * Integer and logical values are accumulated exactly in 64-bit
+ * integers, with branch-free NA tests, which the compiler can
+ * vectorise; the totals are then the same as LDOUBLE accumulation
+ * would give.  NaN tests use std::isnan rather than ISNAN, which in
+ * C++ is an out-of-line call.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "summation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "rho/ThreadPool.hpp"
+
+using namespace rho;
+
+namespace {
+    // Rows per tile in R_rowSums().
+    const R_xlen_t ROW_TILE = 1024;
+
+    // Fewest elements worth giving a thread of their own.
+    const R_xlen_t PARALLEL_GRAIN = 1 << 16;
+
+    // Integer sums are formed in blocks of this many elements, which
+    // cannot overflow an int64_t.
+    const R_xlen_t INT_BLOCK = R_xlen_t(1) << 31;
+
+    void colSumsReal(const double* x, R_xlen_t n, R_xlen_t j0, R_xlen_t j1,
+		     bool narm, bool means, double* ans)
+    {
+	for (R_xlen_t j = j0; j < j1; j++) {
+	    const double* col = x + n * j;
+	    LDOUBLE sum = 0.0;
+	    R_xlen_t cnt = n;
+	    if (!narm)
+		for (R_xlen_t i = 0; i < n; i++)
+		    sum += col[i];
+	    else {
+		cnt = 0;
+		for (R_xlen_t i = 0; i < n; i++) {
+		    double v = col[i];
+		    bool ok = !std::isnan(v);
+		    sum += ok ? v : 0.0;
+		    cnt += ok;
+		}
+	    }
+	    if (means) sum /= cnt; /* gives NaN for cnt = 0 */
+	    ans[j] = double( sum);
+	}
+    }
+
+    // NA_LOGICAL == NA_INTEGER, so logicals can share this.
+    void colSumsInt(const int* x, R_xlen_t n, R_xlen_t j0, R_xlen_t j1,
+		    bool narm, bool means, double* ans)
+    {
+	for (R_xlen_t j = j0; j < j1; j++) {
+	    const int* col = x + n * j;
+	    LDOUBLE sum = 0.0;
+	    R_xlen_t cnt = 0;
+	    int nas = 0;
+	    for (R_xlen_t b = 0; b < n; b += INT_BLOCK) {
+		R_xlen_t e = std::min(n, b + INT_BLOCK);
+		int64_t bsum = 0;
+		for (R_xlen_t i = b; i < e; i++) {
+		    int v = col[i];
+		    int isna = (v == NA_INTEGER);
+		    bsum += isna ? 0 : v;
+		    cnt += 1 - isna;
+		    nas |= isna;
+		}
+		sum += bsum;
+	    }
+	    if (nas && !narm)
+		ans[j] = NA_REAL;
+	    else {
+		if (means) sum /= cnt;
+		ans[j] = double( sum);
+	    }
+	}
+    }
+
+    void rowSumsReal(const double* x, R_xlen_t n, R_xlen_t p,
+		     R_xlen_t i0, R_xlen_t i1, bool narm, bool means,
+		     double* ans)
+    {
+	LDOUBLE acc[ROW_TILE];
+	int cnt[ROW_TILE];
+	for (R_xlen_t t0 = i0; t0 < i1; t0 += ROW_TILE) {
+	    R_xlen_t len = std::min(ROW_TILE, i1 - t0);
+	    std::fill(acc, acc + len, 0.0);
+	    std::fill(cnt, cnt + len, 0);
+	    for (R_xlen_t j = 0; j < p; j++) {
+		const double* col = x + n * j + t0;
+		if (!narm)
+		    for (R_xlen_t i = 0; i < len; i++)
+			acc[i] += col[i];
+		else
+		    for (R_xlen_t i = 0; i < len; i++) {
+			double v = col[i];
+			bool ok = !std::isnan(v);
+			acc[i] += ok ? v : 0.0;
+			cnt[i] += ok;
+		    }
+	    }
+	    if (means) {
+		if (narm)
+		    for (R_xlen_t i = 0; i < len; i++) acc[i] /= cnt[i];
+		else
+		    for (R_xlen_t i = 0; i < len; i++) acc[i] /= p;
+	    }
+	    for (R_xlen_t i = 0; i < len; i++)
+		ans[t0 + i] = double( acc[i]);
+	}
+    }
+
+    void rowSumsInt(const int* x, R_xlen_t n, R_xlen_t p,
+		    R_xlen_t i0, R_xlen_t i1, bool narm, bool means,
+		    double* ans)
+    {
+	int64_t acc[ROW_TILE];
+	int cnt[ROW_TILE];
+	int nas[ROW_TILE];
+	for (R_xlen_t t0 = i0; t0 < i1; t0 += ROW_TILE) {
+	    R_xlen_t len = std::min(ROW_TILE, i1 - t0);
+	    std::fill(acc, acc + len, 0);
+	    std::fill(cnt, cnt + len, 0);
+	    std::fill(nas, nas + len, 0);
+	    for (R_xlen_t j = 0; j < p; j++) {
+		const int* col = x + n * j + t0;
+		for (R_xlen_t i = 0; i < len; i++) {
+		    int v = col[i];
+		    int isna = (v == NA_INTEGER);
+		    acc[i] += isna ? 0 : v;
+		    cnt[i] += 1 - isna;
+		    nas[i] |= isna;
+		}
+	    }
+	    for (R_xlen_t i = 0; i < len; i++) {
+		if (nas[i] && !narm) {
+		    ans[t0 + i] = NA_REAL;
+		    continue;
+		}
+		LDOUBLE sum = acc[i];
+		if (means) sum /= (narm ? cnt[i] : p);
+		ans[t0 + i] = double( sum);
+	    }
+	}
+    }
+
+    void groupSumsReal(const double* x, R_xlen_t n, const int* group,
+		       bool narm, double* ans)
+    {
+	for (R_xlen_t i = 0; i < n; i++)
+	    if (!narm || !std::isnan(x[i]))
+		ans[group[i] - 1] += x[i];
+    }
+
+    void groupSumsInt(const int* x, R_xlen_t n, const int* group,
+		      bool narm, int* ans)
+    {
+	for (R_xlen_t i = 0; i < n; i++) {
+	    int* a = ans + group[i] - 1;
+	    if (x[i] == NA_INTEGER) {
+		if (!narm)
+		    *a = NA_INTEGER;
+	    } else if (*a != NA_INTEGER) {
+		/* check for integer overflows */
+		double dtmp = double(*a) + x[i];
+		if (dtmp < INT_MIN || dtmp > INT_MAX) *a = NA_INTEGER;
+		else *a += x[i];
+	    }
+	}
+    }
+
+    // Column grain for an array with n rows.
+    R_xlen_t columnGrain(R_xlen_t n)
+    {
+	return std::max(R_xlen_t(1), PARALLEL_GRAIN / std::max(n, R_xlen_t(1)));
+    }
+}
+
+void R_colSums(SEXPTYPE type, const void* x, R_xlen_t n, R_xlen_t p,
+	       bool narm, bool means, double* ans)
+{
+    ThreadPool::parallelFor(p, columnGrain(n),
+			    [=](R_xlen_t j0, R_xlen_t j1) {
+	    if (type == REALSXP)
+		colSumsReal(static_cast<const double*>(x), n, j0, j1,
+			    narm, means, ans);
+	    else
+		colSumsInt(static_cast<const int*>(x), n, j0, j1,
+			   narm, means, ans);
+	});
+}
+
+void R_rowSums(SEXPTYPE type, const void* x, R_xlen_t n, R_xlen_t p,
+	       bool narm, bool means, double* ans)
+{
+    // Whole tiles per thread, so that tiles never straddle threads.
+    R_xlen_t ntiles = (n + ROW_TILE - 1) / ROW_TILE;
+    R_xlen_t grain = std::max(R_xlen_t(1),
+			      PARALLEL_GRAIN / (ROW_TILE * std::max(p, R_xlen_t(1))));
+    ThreadPool::parallelFor(ntiles, grain, [=](R_xlen_t b, R_xlen_t e) {
+	    R_xlen_t i0 = b * ROW_TILE, i1 = std::min(n, e * ROW_TILE);
+	    if (type == REALSXP)
+		rowSumsReal(static_cast<const double*>(x), n, p, i0, i1,
+			    narm, means, ans);
+	    else
+		rowSumsInt(static_cast<const int*>(x), n, p, i0, i1,
+			   narm, means, ans);
+	});
+}
+
+void R_groupSums(SEXPTYPE type, const void* const* x, R_xlen_t n,
+		 R_xlen_t p, const int* group, R_xlen_t ng, bool narm,
+		 void* const* ans)
+{
+    ThreadPool::parallelFor(p, columnGrain(n), [=](R_xlen_t j0, R_xlen_t j1) {
+	    for (R_xlen_t j = j0; j < j1; j++) {
+		if (type == REALSXP)
+		    groupSumsReal(static_cast<const double*>(x[j]), n, group,
+				  narm, static_cast<double*>(ans[j]));
+		else
+		    groupSumsInt(static_cast<const int*>(x[j]), n, group,
+				 narm, static_cast<int*>(ans[j]));
+	    }
+	});
+}
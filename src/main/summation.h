@@ -0,0 +1,53 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Kernels behind colSums(), rowSums(), colMeans(), rowMeans() and
+ * rowsum().  They work on the raw contents of LGLSXP, INTSXP and
+ * REALSXP vectors, share the work out over rho::ThreadPool, and give
+ * the same results, bit for bit, as a single-threaded loop.
+ */
+
+#ifndef SUMMATION_H
+#define SUMMATION_H 1
+
+#include <Defn.h>
+
+/* ans[j] = sum (or mean, if 'means') of column j of the n x p
+   column-major array x, of type 'type'.  NAs are skipped if 'narm',
+   otherwise they make the result NA. */
+void R_colSums(SEXPTYPE type, const void* x, R_xlen_t n, R_xlen_t p,
+	       bool narm, bool means, double* ans);
+
+/* ans[i] = sum (or mean) of row i of x, as for R_colSums. */
+void R_rowSums(SEXPTYPE type, const void* x, R_xlen_t n, R_xlen_t p,
+	       bool narm, bool means, double* ans);
+
+/* Grouped sums of the p columns x[j] (each of length n, of type
+   INTSXP or REALSXP) into the p columns ans[j] (each of length ng, of
+   the same type, and zeroed by the caller).  group[i] is the 1-based
+   group of element i.  Integer overflow gives NA, as in rowsum(). */
+void R_groupSums(SEXPTYPE type, const void* const* x, R_xlen_t n,
+		 R_xlen_t p, const int* group, R_xlen_t ng, bool narm,
+		 void* const* ans);
+
+#endif /* SUMMATION_H */
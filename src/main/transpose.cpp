@@ -0,0 +1,287 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Blocked transpose and aperm kernels: see transpose.h.
+ *
+ * A naive transpose reads one of its two arrays with a stride of a
+ * whole column, so that once a column no longer fits in cache every
+ * element access misses.  R_transpose() instead works on TILE x TILE
+ * blocks, each of which, with its image, lies in L1 cache.  The order
+ * in which blocks are visited matters nearly as much: stores that
+ * miss cost more than loads, so blocks are taken a band of result
+ * rows at a time, and the result is written as TILE sequential
+ * streams that the hardware prefetcher can follow.
+ *
+ * R_aperm() reduces a general permutation to one of two cases.  If
+ * the first dimension of the result is the first of the source, the
+ * leading dimensions that stay in place form contiguous runs, which
+ * are copied with memcpy().  Otherwise the first dimensions of source
+ * and result are swapped by a strided transpose, repeated for every
+ * combination of the remaining indices.
+ *
+ * Large problems are divided between the threads of rho::ThreadPool.
+ * Elements are copied bit for bit, so NA and NaN payloads survive.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "transpose.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "rho/ThreadPool.hpp"
+
+using namespace rho;
+
+namespace {
+    // Side of the blocks transposed directly.
+    const R_xlen_t TILE = 32;
+
+    // Longest result row swept without tiling.
+    const R_xlen_t SHORT_ROW = 1024;
+
+    // Fewest elements worth giving a thread of their own.
+    const R_xlen_t PARALLEL_GRAIN = 1 << 16;
+
+    struct Bytes16 {
+	uint64_t lo, hi;
+    };
+
+    // out[i + j*os] = in[j + i*is] for an ni x nj block.  The inner
+    // loop is a plain gather, which the compiler can vectorise.
+    template <typename T>
+    void transposeTile(const T* in, T* out, R_xlen_t ni, R_xlen_t nj,
+		       R_xlen_t is, R_xlen_t os)
+    {
+	for (R_xlen_t j = 0; j < nj; j++) {
+	    const T* src = in + j;
+	    T* dest = out + j*os;
+	    for (R_xlen_t i = 0; i < ni; i++)
+		dest[i] = src[i*is];
+	}
+    }
+
+    // Tiles are visited in bands of TILE rows of the result, each band
+    // swept from left to right, so that the result is written as TILE
+    // sequential streams.
+    template <typename T>
+    void transposeBands(const T* in, T* out, R_xlen_t ni, R_xlen_t nj,
+			R_xlen_t is, R_xlen_t os)
+    {
+	// Short result rows are swept whole: the cache lines of the
+	// source that feed a band then stay in cache across the band.
+	R_xlen_t ti = (ni <= SHORT_ROW ? ni : TILE);
+	for (R_xlen_t j0 = 0; j0 < nj; j0 += TILE) {
+	    R_xlen_t tj = std::min(TILE, nj - j0);
+	    for (R_xlen_t i0 = 0; i0 < ni; i0 += ti)
+		transposeTile(in + j0 + i0*is, out + i0 + j0*os,
+			      std::min(ti, ni - i0), tj, is, os);
+	}
+    }
+
+    template <typename T>
+    void transposeParallel(const T* in, T* out, R_xlen_t ni, R_xlen_t nj,
+			   R_xlen_t is, R_xlen_t os)
+    {
+	if (ni == 0 || nj == 0)
+	    return;
+	// Threads take whole bands.
+	R_xlen_t nbands = (nj + TILE - 1)/TILE;
+	R_xlen_t grain = std::max(R_xlen_t(1), PARALLEL_GRAIN/(TILE*ni));
+	ThreadPool::parallelFor(nbands, grain, [=](R_xlen_t b, R_xlen_t e) {
+		R_xlen_t j0 = b*TILE, j1 = std::min(nj, e*TILE);
+		transposeBands(in + j0, out + j0*os, ni, j1 - j0, is, os);
+	    });
+    }
+
+    // One dimension of an aperm() not handled by the inner kernel:
+    // its extent and strides in source and result.
+    struct OuterDim {
+	R_xlen_t extent, in_stride, out_stride;
+    };
+
+    // Calls body(in_offset, out_offset) for each outer index in
+    // [b, e), in column-major order of the outer dimensions.
+    template <typename F>
+    void forOuter(const std::vector<OuterDim>& dims, R_xlen_t b, R_xlen_t e,
+		  F body)
+    {
+	size_t nd = dims.size();
+	std::vector<R_xlen_t> idx(nd);
+	R_xlen_t ioff = 0, ooff = 0, rest = b;
+	for (size_t d = 0; d < nd; d++) {
+	    idx[d] = rest % dims[d].extent;
+	    rest /= dims[d].extent;
+	    ioff += idx[d]*dims[d].in_stride;
+	    ooff += idx[d]*dims[d].out_stride;
+	}
+	for (R_xlen_t k = b; k < e; k++) {
+	    body(ioff, ooff);
+	    for (size_t d = 0; d < nd; d++) {
+		ioff += dims[d].in_stride;
+		ooff += dims[d].out_stride;
+		if (++idx[d] < dims[d].extent)
+		    break;
+		ioff -= dims[d].extent*dims[d].in_stride;
+		ooff -= dims[d].extent*dims[d].out_stride;
+		idx[d] = 0;
+	    }
+	}
+    }
+
+    template <typename T>
+    void aperm(const T* in, T* out, int n, const int* dims, const int* perm)
+    {
+	std::vector<R_xlen_t> in_stride(n), out_stride(n);
+	R_xlen_t len = 1;
+	for (int d = 0; d < n; d++) {
+	    in_stride[d] = len;
+	    len *= dims[d];
+	}
+	if (len == 0)
+	    return;
+	len = 1;
+	for (int k = 0; k < n; k++) {
+	    out_stride[k] = len;
+	    len *= dims[perm[k]];
+	}
+
+	// Result dimensions in order, dropping those of extent 1.
+	std::vector<int> keep;
+	for (int k = 0; k < n; k++)
+	    if (dims[perm[k]] > 1)
+		keep.push_back(k);
+	if (keep.empty()) {
+	    out[0] = in[0];
+	    return;
+	}
+	// The source dimension that is innermost among those kept.
+	int first_src = n;
+	for (int k : keep)
+	    first_src = std::min(first_src, perm[k]);
+
+	std::vector<OuterDim> outer;
+	if (perm[keep[0]] == first_src) {
+	    // Leading dimensions that keep their order, and lie
+	    // contiguously in the source, are copied as runs.
+	    R_xlen_t run = 1;
+	    size_t m = 0;
+	    while (m < keep.size() && in_stride[perm[keep[m]]] == run) {
+		run *= dims[perm[keep[m]]];
+		m++;
+	    }
+	    for (size_t t = m; t < keep.size(); t++) {
+		int k = keep[t];
+		outer.push_back({dims[perm[k]], in_stride[perm[k]],
+			    out_stride[k]});
+	    }
+	    R_xlen_t nouter = len/run;
+	    R_xlen_t grain = std::max(R_xlen_t(1), PARALLEL_GRAIN/run);
+	    ThreadPool::parallelFor(nouter, grain, [&](R_xlen_t b, R_xlen_t e) {
+		    forOuter(outer, b, e, [&](R_xlen_t io, R_xlen_t oo) {
+			    std::memcpy(out + oo, in + io, run*sizeof(T));
+			});
+		});
+	    return;
+	}
+
+	// Transpose the innermost kept dimensions of source and result,
+	// for every combination of the other indices.
+	int ki = keep[0], kj = -1;
+	for (int k : keep)
+	    if (perm[k] == first_src)
+		kj = k;
+	for (int k : keep)
+	    if (k != ki && k != kj)
+		outer.push_back({dims[perm[k]], in_stride[perm[k]],
+			    out_stride[k]});
+	R_xlen_t ni = dims[perm[ki]], nj = dims[first_src];
+	R_xlen_t is = in_stride[perm[ki]], os = out_stride[kj];
+	R_xlen_t nouter = len/(ni*nj);
+	if (nouter == 1) {
+	    transposeParallel(in, out, ni, nj, is, os);
+	    return;
+	}
+	R_xlen_t grain = std::max(R_xlen_t(1), PARALLEL_GRAIN/(ni*nj));
+	ThreadPool::parallelFor(nouter, grain, [&](R_xlen_t b, R_xlen_t e) {
+		forOuter(outer, b, e, [&](R_xlen_t io, R_xlen_t oo) {
+			transposeBands(in + io, out + oo, ni, nj, is, os);
+		    });
+	    });
+    }
+}
+
+void R_transpose(const void* in, void* out, R_xlen_t ni, R_xlen_t nj,
+		 R_xlen_t is, R_xlen_t os, size_t esize)
+{
+    switch (esize) {
+    case 1:
+	transposeParallel(static_cast<const uint8_t*>(in),
+			  static_cast<uint8_t*>(out), ni, nj, is, os);
+	break;
+    case 4:
+	transposeParallel(static_cast<const uint32_t*>(in),
+			  static_cast<uint32_t*>(out), ni, nj, is, os);
+	break;
+    case 8:
+	transposeParallel(static_cast<const uint64_t*>(in),
+			  static_cast<uint64_t*>(out), ni, nj, is, os);
+	break;
+    case 16:
+	transposeParallel(static_cast<const Bytes16*>(in),
+			  static_cast<Bytes16*>(out), ni, nj, is, os);
+	break;
+    default:
+	error("unsupported element size in R_transpose");
+    }
+}
+
+void R_aperm(const void* in, void* out, int n, const int* dims,
+	     const int* perm, size_t esize)
+{
+    switch (esize) {
+    case 1:
+	aperm(static_cast<const uint8_t*>(in), static_cast<uint8_t*>(out),
+	      n, dims, perm);
+	break;
+    case 4:
+	aperm(static_cast<const uint32_t*>(in), static_cast<uint32_t*>(out),
+	      n, dims, perm);
+	break;
+    case 8:
+	aperm(static_cast<const uint64_t*>(in), static_cast<uint64_t*>(out),
+	      n, dims, perm);
+	break;
+    case 16:
+	aperm(static_cast<const Bytes16*>(in), static_cast<Bytes16*>(out),
+	      n, dims, perm);
+	break;
+    default:
+	error("unsupported element size in R_aperm");
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Kernels behind t() and aperm() for vectors whose elements are plain
+ * data (raw, logical, integer, double and complex): see transpose.cpp.
+ * 'esize' is the size in bytes of an element, and must be 1, 4, 8 or
+ * 16.
+ */
+
+#ifndef TRANSPOSE_H
+#define TRANSPOSE_H 1
+
+#include <Defn.h>
+
+/* out[i + j*os] = in[j + i*is] for 0 <= i < ni and 0 <= j < nj.  With
+   is = nrow and os = ncol, and ni = ncol, nj = nrow, this is the
+   transpose of an nrow x ncol matrix. */
+void R_transpose(const void* in, void* out, R_xlen_t ni, R_xlen_t nj,
+		 R_xlen_t is, R_xlen_t os, size_t esize);
+
+/* out = aperm(in, perm), where 'in' has the n dimensions dims, and
+   result dimension k is dimension perm[k] (0-based) of 'in'. */
+void R_aperm(const void* in, void* out, int n, const int* dims,
+	     const int* perm, size_t esize);
+
+#endif /* TRANSPOSE_H */
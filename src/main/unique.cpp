@@ -37,6 +37,9 @@
 #include "rho/DottedArgs.hpp"
 #include "rho/Promise.hpp"
 #include "rho/RAllocStack.hpp"
+#include "summation.h"
+
+#include <vector>
 
 using namespace rho;
 
@@ -1451,40 +1454,29 @@ rowsum(SEXP x, SEXP g, SEXP uniqueg, SEXP snarm, SEXP rn)
     switch(TYPEOF(x)){
     case REALSXP:
 	Memzero(REAL(ans), ng*p);
-	for(int i = 0; i < p; i++) {
-	    for(int j = 0; j < n; j++)
-		if(!narm || !ISNAN(REAL(x)[j + offset]))
-		    REAL(ans)[INTEGER(matches)[j] - 1 + offsetg]
-			+= REAL(x)[j + offset];
-	    offset += n;
-	    offsetg += ng;
-	}
 	break;
     case INTSXP:
 	Memzero(INTEGER(ans), ng*p);
+	break;
+    default:
+	error(_("non-numeric matrix in rowsum(): this should not happen"));
+    }
+    {
+	std::vector<const void*> xcols(p);
+	std::vector<void*> anscols(p);
 	for(int i = 0; i < p; i++) {
-	    for(int j = 0; j < n; j++) {
-		if (INTEGER(x)[j + offset] == NA_INTEGER) {
-		    if(!narm)
-			INTEGER(ans)[INTEGER(matches)[j] - 1 + offsetg]
-			    = NA_INTEGER;
-		} else if (INTEGER(ans)[INTEGER(matches)[j] - 1 + offsetg]
-			   != NA_INTEGER) {
-		    /* check for integer overflows */
-		    int itmp = INTEGER(ans)[INTEGER(matches)[j] - 1 + offsetg];
-		    double dtmp = itmp;
-		    dtmp += INTEGER(x)[j + offset];
-		    if (dtmp < INT_MIN || dtmp > INT_MAX) itmp = NA_INTEGER;
-		    else itmp += INTEGER(x)[j + offset];
-		    INTEGER(ans)[INTEGER(matches)[j] - 1 + offsetg] = itmp;
-		}
+	    if (TYPEOF(x) == REALSXP) {
+		xcols[i] = REAL(x) + offset;
+		anscols[i] = REAL(ans) + offsetg;
+	    } else {
+		xcols[i] = INTEGER(x) + offset;
+		anscols[i] = INTEGER(ans) + offsetg;
 	    }
 	    offset += n;
 	    offsetg += ng;
 	}
-	break;
-    default:
-	error(_("non-numeric matrix in rowsum(): this should not happen"));
+	R_groupSums(TYPEOF(x), xcols.data(), n, p, INTEGER(matches), ng,
+		    narm, anscols.data());
     }
 
     if (TYPEOF(rn) != STRSXP) error("row names are not character");
@@ -1520,44 +1512,38 @@ rowsum_df(SEXP x, SEXP g, SEXP uniqueg, SEXP snarm, SEXP rn)
 
     PROTECT(ans = allocVector(VECSXP, p));
 
+    /* Allocate all the result columns first, then sum the real and
+       the integer columns as two batches. */
+    std::vector<const void*> xreal, xint;
+    std::vector<void*> ansreal, ansint;
     for(int i = 0; i < p; i++) {
 	xcol = VECTOR_ELT(x,i);
 	if (!isNumeric(xcol))
 	    error(_("non-numeric data frame in rowsum"));
 	switch(TYPEOF(xcol)){
 	case REALSXP:
-	    PROTECT(col = allocVector(REALSXP,ng));
-	    Memzero(REAL(col), ng);
-	    for(R_xlen_t j = 0; j < n; j++)
-		if(!narm || !ISNAN(REAL(xcol)[j]))
-		    REAL(col)[INTEGER(matches)[j] - 1] += REAL(xcol)[j];
+	    col = allocVector(REALSXP,ng);
 	    SET_VECTOR_ELT(ans,i,col);
-	    UNPROTECT(1);
+	    Memzero(REAL(col), ng);
+	    xreal.push_back(REAL(xcol));
+	    ansreal.push_back(REAL(col));
 	    break;
 	case INTSXP:
-	    PROTECT(col = allocVector(INTSXP, ng));
-	    Memzero(INTEGER(col), ng);
-	    for(R_xlen_t j = 0; j < n; j++) {
-		if (INTEGER(xcol)[j] == NA_INTEGER) {
-		    if(!narm)
-			INTEGER(col)[INTEGER(matches)[j] - 1] = NA_INTEGER;
-		} else if (INTEGER(col)[INTEGER(matches)[j] - 1] != NA_INTEGER) {
-		    int itmp = INTEGER(col)[INTEGER(matches)[j] - 1];
-		    double dtmp = itmp;
-		    dtmp += INTEGER(xcol)[j];
-		    if (dtmp < INT_MIN || dtmp > INT_MAX) itmp = NA_INTEGER;
-		    else itmp += INTEGER(xcol)[j];
-		    INTEGER(col)[INTEGER(matches)[j] - 1] = itmp;
-		}
-	    }
+	    col = allocVector(INTSXP, ng);
 	    SET_VECTOR_ELT(ans, i, col);
-	    UNPROTECT(1);
+	    Memzero(INTEGER(col), ng);
+	    xint.push_back(INTEGER(xcol));
+	    ansint.push_back(INTEGER(col));
 	    break;
 
 	default:
 	    error(_("this cannot happen"));
 	}
     }
+    R_groupSums(REALSXP, xreal.data(), n, xreal.size(), INTEGER(matches),
+		ng, narm, ansreal.data());
+    R_groupSums(INTSXP, xint.data(), n, xint.size(), INTEGER(matches),
+		ng, narm, ansint.data());
     namesgets(ans, getAttrib(x, R_NamesSymbol));
 
     if (TYPEOF(rn) != STRSXP) error("row names are not character");
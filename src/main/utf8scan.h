@@ -0,0 +1,102 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Word-at-a-time kernels for scanning UTF-8 and ASCII strings, used
+ * by nchar(), substr(), strtrim(), validUTF8() and rho::String.  Each
+ * looks at eight bytes at once, which are all ASCII when none has its
+ * top bit set, and only drops to a byte at a time where there is
+ * something to decode.
+ */
+
+#ifndef UTF8SCAN_H
+#define UTF8SCAN_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define R_UTF8SCAN_HIGH_BITS UINT64_C(0x8080808080808080)
+
+static inline uint64_t R_utf8scan_word(const char *s)
+{
+    uint64_t w;
+    memcpy(&w, s, sizeof w);
+    return w;
+}
+
+/* Number of leading ASCII bytes among the n at s. */
+static inline size_t R_ascii_span(const char *s, size_t n)
+{
+    size_t i = 0;
+    while (i + 8 <= n && !(R_utf8scan_word(s + i) & R_UTF8SCAN_HIGH_BITS))
+	i += 8;
+    while (i < n && !(s[i] & 0x80))
+	i++;
+    return i;
+}
+
+/* Number of characters in the n bytes of valid UTF-8 at s: the bytes
+   that are not continuation bytes, 10xxxxxx. */
+static inline size_t R_utf8_count(const char *s, size_t n)
+{
+    size_t i = 0, cont = 0;
+    for (; i + 8 <= n; i += 8) {
+	uint64_t w = R_utf8scan_word(s + i);
+	/* The top bit of each byte that is 10xxxxxx. */
+	uint64_t c = w & ~(w << 1) & R_UTF8SCAN_HIGH_BITS;
+#ifdef __GNUC__
+	cont += (size_t) __builtin_popcountll(c);
+#else
+	for (; c; c &= c - 1) cont++;
+#endif
+    }
+    for (; i < n; i++)
+	cont += ((s[i] & 0xc0) == 0x80);
+    return n - cont;
+}
+
+/* Offset of the byte after the first k characters of the n bytes at
+   s, stepping over characters as utf8clen() does, but at most n. */
+static inline size_t R_utf8_advance(const char *s, size_t n, size_t k)
+{
+    static const unsigned char extra[] = {
+	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+	2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+	3,3,3,3,3,3,3,3,4,4,4,4,5,5,5,5 };
+    size_t i = 0;
+    while (k > 0 && i < n) {
+	if (k >= 8 && i + 8 <= n
+	    && !(R_utf8scan_word(s + i) & R_UTF8SCAN_HIGH_BITS)) {
+	    i += 8;
+	    k -= 8;
+	    continue;
+	}
+	unsigned char c = (unsigned char) s[i];
+	i += (c < 0xc0) ? 1 : 1 + extra[c & 0x3f];
+	k--;
+    }
+    return i < n ? i : n;
+}
+
+#endif /* UTF8SCAN_H */
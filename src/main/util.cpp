@@ -32,6 +32,7 @@
 #include <Internal.h>
 #include <R_ext/Print.h>
 #include "basedecl.h"
+#include "utf8scan.h"
 
 #include <vector>
 #include "rho/BuiltInFunction.hpp"
@@ -1158,10 +1159,8 @@ SEXP attribute_hidden markKnown(const char *s, SEXP ref)
 
 Rboolean strIsASCII(const char *str)
 {
-    const char *p;
-    for(p = str; *p; p++)
-	if(static_cast<unsigned int>(*p) > 0x7F) return FALSE;
-    return TRUE;
+    size_t n = strlen(str);
+    return Rboolean(R_ascii_span(str, n) == n);
 }
 
 /* Number of additional bytes */
@@ -1371,8 +1370,10 @@ SEXP attribute_hidden do_validUTF8(rho::Expression* call, const rho::BuiltInFunc
     R_xlen_t n = XLENGTH(x);
     SEXP ans = allocVector(LGLSXP, n); // no allocation below
     int *lans = LOGICAL(ans);
-    for (R_xlen_t i = 0; i < n; i++)
-	lans[i] = utf8Valid(CHAR(STRING_ELT(x, i)));
+    for (R_xlen_t i = 0; i < n; i++) {
+	SEXP el = STRING_ELT(x, i);
+	lans[i] = IS_ASCII(el) || valid_utf8(CHAR(el), LENGTH(el)) == 0;
+    }
     return ans;
 }
 
@@ -1707,6 +1708,19 @@ double R_strtod5(const char *str, char **endptr, char dec,
 	expn += expsign * n;
     }
 
+    /* Clinger's fast path: a mantissa of at most 53 bits scaled by an
+       exactly representable power of ten is correctly rounded by a
+       single double multiplication or division. */
+    if (ans <= 9007199254740992.0 && expn >= -22 && expn <= 22) {
+	static const double pow10[] = {
+	    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	double mant = double( ans);
+	ans = (expn < 0) ? mant / pow10[-expn] : mant * pow10[expn];
+	goto done;
+    }
+
     /* avoid unnecessary underflow for large negative exponents */
     if (expn + ndigits < -300) {
 	for (n = 0; n < ndigits; n++) ans /= 10.0;
@@ -63,6 +63,8 @@ characters is still checked.
 
 */
 
+#include "utf8scan.h"
+
 static int
 valid_utf8(const char *string, size_t length) // R change int->size_t
 {
@@ -71,7 +73,12 @@ valid_utf8(const char *string, size_t length) // R change int->size_t
     for (p = string; length-- > 0; p++) {
 	int ab, c, d;
 	c = (unsigned char)*p;
-	if (c < 128) continue;                /* ASCII character */
+	if (c < 128) {                        /* ASCII character */
+	    size_t run = R_ascii_span(p + 1, length); /* and any after it */
+	    p += run;
+	    length -= run;
+	    continue;
+	}
 	if (c < 0xc0) return 1;               /* Isolated 10xx xxxx byte */
 	if (c >= 0xfe) return 1;             /* Invalid 0xfe or 0xff bytes */
 
@@ -0,0 +1,81 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+#include "gtest/gtest.h"
+#include "rho/ThreadPool.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace rho;
+
+// Every index is visited exactly once.
+TEST(ThreadPoolTest, RunVisitsEachTaskOnce) {
+  std::vector<std::atomic<int>> visits(1000);
+  for (auto& v : visits)
+    v = 0;
+  ThreadPool::run(visits.size(), [&](std::size_t i) { ++visits[i]; });
+  for (auto& v : visits)
+    EXPECT_EQ(1, v.load());
+}
+
+// The subranges passed to the body partition the whole range.
+TEST(ThreadPoolTest, ParallelForCoversRange) {
+  const std::size_t n = 100003;
+  std::vector<char> seen(n, 0);
+  std::atomic<std::size_t> total(0);
+  ThreadPool::parallelFor(n, 100, [&](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; ++i)
+        seen[i]++;
+      total += e - b;
+    });
+  EXPECT_EQ(n, total.load());
+  for (std::size_t i = 0; i < n; ++i)
+    EXPECT_EQ(1, seen[i]);
+}
+
+// Nested requests run inline rather than deadlocking.
+TEST(ThreadPoolTest, NestedRequestsRunInline) {
+  std::atomic<int> count(0);
+  ThreadPool::run(8, [&](std::size_t) {
+      ThreadPool::parallelFor(1000, 1, [&](std::size_t b, std::size_t e) {
+          EXPECT_TRUE(ThreadPool::inWorker());
+          count += e - b;
+        });
+    });
+  EXPECT_EQ(8000, count.load());
+  EXPECT_FALSE(ThreadPool::inWorker());
+}
+
+// Exceptions thrown by a task reach the caller.
+TEST(ThreadPoolTest, ExceptionsPropagate) {
+  EXPECT_THROW(ThreadPool::run(16, [](std::size_t i) {
+        if (i == 11)
+          throw std::runtime_error("task failed");
+      }), std::runtime_error);
+  // The pool is still usable afterwards.
+  std::atomic<int> count(0);
+  ThreadPool::run(16, [&](std::size_t) { ++count; });
+  EXPECT_EQ(16, count.load());
+}